@@ -0,0 +1,193 @@
+#include "defines.hpp"
+#include "direct.hpp"
+#include "helpers.hpp"
+#include "quadtree.hpp"
+#include "rectangle.hpp"
+#include "spawns.hpp"
+#include "utils.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <functional>
+#include <thread>
+#include <vector>
+
+using std::vector, sf::Vector2f, sf::Vector3;
+using bench_clock = std::chrono::steady_clock;
+using Reference = BasicParticle<DoublePrecision>;
+
+#define DRIFT_STEPS 100
+
+// Barnes-Hut forces and conservation against exact direct summation, for
+// the spawns.cpp scenes and a range of opening ratios.
+
+struct Scene {
+  const char *name;
+  std::function<void(vector<Particle> &)> spawn;
+};
+
+struct Drift {
+  double energy;
+  double momentum;
+  double ms_per_step;
+};
+
+static double elapsed_ms(bench_clock::time_point start) {
+  std::chrono::duration<double, std::milli> elapsed = bench_clock::now() - start;
+  return elapsed.count();
+}
+
+static double percentile(vector<double> &sorted, double p) {
+  return sorted[std::min(sorted.size() - 1, (size_t)(p * sorted.size()))];
+}
+
+static void build_tree(QuadTree &qt, vector<Particle> &particles) {
+  for (auto &particle : particles) {
+    qt.insert(particle);
+  }
+  qt.update_mass();
+}
+
+static Drift measure_drift(vector<Particle> particles,
+                           std::function<void(vector<Particle> &)> forces) {
+  auto energy = [](vector<Particle> &particles) {
+    double kinetic = 0.0;
+    for (auto &particle : particles) {
+      kinetic += 0.5 * particle.mass * dot(particle.vel, particle.vel);
+    }
+    return kinetic + calc_direct_potential(particles);
+  };
+  // Momentum change is relative to the larger sum of |m v| of the two ends,
+  // scenes that start at rest have none at the start.
+  auto momentum = [](vector<Particle> &particles, double &scale) {
+    Vector3<double> total(0.0, 0.0, 0.0);
+    for (auto &particle : particles) {
+      total += extend(particle.vel) * (double)particle.mass;
+      scale += particle.mass * norm(particle.vel);
+    }
+    return total;
+  };
+
+  double scale_start = 0.0;
+  double energy_start = energy(particles);
+  Vector3<double> momentum_start = momentum(particles, scale_start);
+
+  Diagnostics diagnostics;
+  auto start = bench_clock::now();
+  for (int step = 0; step < DRIFT_STEPS; step++) {
+    forces(particles);
+    for (auto &particle : particles) {
+      apply_force(particle, diagnostics);
+    }
+  }
+  double ms_per_step = elapsed_ms(start) / DRIFT_STEPS;
+
+  double scale_end = 0.0;
+  Vector3<double> momentum_change =
+      momentum(particles, scale_end) - momentum_start;
+  return {std::abs(energy(particles) - energy_start) / std::abs(energy_start),
+          norm(momentum_change) / std::max(scale_start, scale_end),
+          ms_per_step};
+}
+
+static void run_scene(Scene &scene, vector<float> &thetas, int threads) {
+  vector<Particle> particles;
+  scene.spawn(particles);
+
+  vector<Reference> reference;
+  for (auto &particle : particles) {
+    reference.push_back(Reference(particle));
+  }
+  calc_direct_forces(reference, threads);
+
+  std::printf("\n%s, %zu bodies\n", scene.name, particles.size());
+  std::printf("%-8s %10s %10s %10s %10s %10s %10s %10s %10s\n", "theta",
+              "err p50", "err p90", "err p99", "err max", "inter/body",
+              "force ms", "dE/E", "dP/P");
+
+  Rectangle bounds = Rectangle::world();
+  for (float theta : thetas) {
+    QuadTree qt(bounds);
+    build_tree(qt, particles);
+
+    long interactions = 0;
+    auto start = bench_clock::now();
+    for (auto &particle : particles) {
+      particle.netForce = Particle::force_t();
+      particle.potential = 0.0;
+      interactions += qt.calc_force(particle, theta);
+    }
+    double force_ms = elapsed_ms(start);
+
+    vector<double> errors;
+    for (size_t i = 0; i < particles.size(); i++) {
+      Vector3<double> exact = extend(reference[i].netForce);
+      double exact_norm = norm(exact);
+      if (exact_norm > 0.0) {
+        errors.push_back(distance(extend(particles[i].netForce), exact) /
+                         exact_norm);
+      }
+    }
+    std::sort(errors.begin(), errors.end());
+
+    Drift drift = measure_drift(particles, [&](vector<Particle> &particles) {
+      QuadTree step_qt(bounds);
+      build_tree(step_qt, particles);
+      for (auto &particle : particles) {
+        particle.netForce = Particle::force_t();
+        particle.potential = 0.0;
+        step_qt.calc_force(particle, theta);
+      }
+    });
+
+    std::printf("%-8.2f %10.2e %10.2e %10.2e %10.2e %10.1f %10.3f %10.2e "
+                "%10.2e\n",
+                theta, percentile(errors, 0.5), percentile(errors, 0.9),
+                percentile(errors, 0.99), errors.back(),
+                (double)interactions / particles.size(), force_ms,
+                drift.energy, drift.momentum);
+  }
+
+  auto start = bench_clock::now();
+  calc_direct_forces(particles, 1);
+  double serial_ms = elapsed_ms(start);
+  start = bench_clock::now();
+  calc_direct_forces(particles, threads);
+  double threaded_ms = elapsed_ms(start);
+
+  Drift drift = measure_drift(particles, [&](vector<Particle> &particles) {
+    calc_direct_forces(particles, threads);
+  });
+
+  std::printf("%-8s %54.1f %10.3f %10.2e %10.2e\n", "direct",
+              (double)particles.size(), threaded_ms, drift.energy,
+              drift.momentum);
+  std::printf("direct: %.3f ms on 1 thread, %.3f ms on %d threads\n",
+              serial_ms, threaded_ms, threads);
+}
+
+int main() {
+  Vector2f center(WIDTH / 2.0, HEIGHT / 2.0);
+  vector<Scene> scenes = {
+      {"circle", [&](vector<Particle> &p) { spawn_circle(p, center); }},
+      {"spinning circle",
+       [&](vector<Particle> &p) { spawn_spinning_circle(p, center); }},
+      {"galaxy",
+       [&](vector<Particle> &p) {
+         spawn_galaxy(p, center, Vector2f(0.0, 0.0), 1000.0, 200.0);
+       }},
+      {"screen", [&](vector<Particle> &p) { spawn_screen(p); }},
+  };
+  vector<float> thetas = {0.1, 0.25, 0.5, 0.75, 1.0};
+  int threads = std::max(1u, std::thread::hardware_concurrency());
+
+  std::printf("Force errors relative to double direct summation, drift "
+              "over %d steps.\n",
+              DRIFT_STEPS);
+  for (auto &scene : scenes) {
+    run_scene(scene, thetas, threads);
+  }
+
+  return 0;
+}
@@ -0,0 +1,152 @@
+#include "defines.hpp"
+#include "direct.hpp"
+#include "helpers.hpp"
+#include "quadtree.hpp"
+#include "rectangle.hpp"
+#include "spawns.hpp"
+#include "utils.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+using std::vector, sf::Vector2f, sf::Vector3;
+using bench_clock = std::chrono::steady_clock;
+
+#define BENCH_REPEATS 10
+#define BENCH_STEPS 200
+
+// Throughput/accuracy trade-off of the precision policies on the default
+// galaxy. Errors are measured against the DoublePrecision run of the same
+// tree or direct code, so they only reflect round-off, not the opening
+// criterion. The scalar tree walk costs about the same in every mode, the
+// vectorized direct summation is where narrower types pay off.
+
+struct Result {
+  double force_ms;
+  double direct_ms;
+  double step_ms;
+  vector<Vector3<double>> forces;
+  vector<Vector3<double>> direct_forces;
+  vector<Vector3<double>> positions;
+};
+
+template <typename P> Result run(const vector<Particle> &initial) {
+  Result result;
+  vector<BasicParticle<P>> particles;
+  particles.reserve(initial.size());
+  for (const auto &particle : initial) {
+    particles.push_back(BasicParticle<P>(particle));
+  }
+
+  Rectangle bounds = Rectangle::world();
+  BasicQuadTree<P> qt(bounds);
+  for (auto &particle : particles) {
+    qt.insert(particle);
+  }
+  qt.update_mass();
+
+  auto start = bench_clock::now();
+  for (int repeat = 0; repeat < BENCH_REPEATS; repeat++) {
+    for (auto &particle : particles) {
+      particle.netForce = typename BasicParticle<P>::force_t();
+      particle.potential = 0.0;
+      qt.calc_force(particle);
+    }
+  }
+  std::chrono::duration<double, std::milli> force_time =
+      bench_clock::now() - start;
+  result.force_ms = force_time.count() / BENCH_REPEATS;
+
+  for (const auto &particle : particles) {
+    result.forces.push_back(extend(particle.netForce));
+  }
+
+  vector<BasicParticle<P>> direct_particles = particles;
+  start = bench_clock::now();
+  for (int repeat = 0; repeat < BENCH_REPEATS; repeat++) {
+    calc_direct_forces(direct_particles);
+  }
+  std::chrono::duration<double, std::milli> direct_time =
+      bench_clock::now() - start;
+  result.direct_ms = direct_time.count() / BENCH_REPEATS;
+
+  for (const auto &particle : direct_particles) {
+    result.direct_forces.push_back(extend(particle.netForce));
+  }
+
+  Diagnostics diagnostics;
+  start = bench_clock::now();
+  for (int step = 0; step < BENCH_STEPS; step++) {
+    BasicQuadTree<P> step_qt(bounds);
+    for (auto &particle : particles) {
+      step_qt.insert(particle);
+    }
+    step_qt.update_mass();
+    for (auto &particle : particles) {
+      calc_new_pos(particle, step_qt, diagnostics);
+    }
+  }
+  std::chrono::duration<double, std::milli> step_time =
+      bench_clock::now() - start;
+  result.step_ms = step_time.count() / BENCH_STEPS;
+
+  for (const auto &particle : particles) {
+    result.positions.push_back(extend(particle.pos));
+  }
+
+  return result;
+}
+
+// Sorted relative errors of forces against the reference forces.
+static vector<double> force_errors(const vector<Vector3<double>> &forces,
+                                   const vector<Vector3<double>> &reference) {
+  vector<double> errors;
+  for (size_t i = 0; i < forces.size(); i++) {
+    double ref_norm = norm(reference[i]);
+    if (ref_norm > 0.0) {
+      errors.push_back(distance(forces[i], reference[i]) / ref_norm);
+    }
+  }
+  std::sort(errors.begin(), errors.end());
+  return errors;
+}
+
+void report(const char *name, const Result &result, const Result &reference) {
+  vector<double> tree_errors = force_errors(result.forces, reference.forces);
+  vector<double> direct_errors =
+      force_errors(result.direct_forces, reference.direct_forces);
+
+  double pos_error_sq = 0.0;
+  for (size_t i = 0; i < result.positions.size(); i++) {
+    Vector3<double> drift = result.positions[i] - reference.positions[i];
+    pos_error_sq += dot(drift, drift);
+  }
+  double pos_rms = std::sqrt(pos_error_sq / result.positions.size());
+
+  std::printf("%-8s %10.3f %10.3f %10.3f %12.3e %12.3e %12.3e %12.3e\n", name,
+              result.force_ms, result.direct_ms, result.step_ms,
+              tree_errors[tree_errors.size() / 2], tree_errors.back(),
+              direct_errors[direct_errors.size() / 2], pos_rms);
+}
+
+int main() {
+  vector<Particle> particles;
+  spawn_galaxy(particles, Vector2f(WIDTH / 2.0, HEIGHT / 2.0),
+               Vector2f(0.0, 0.0), 1000.0, 200.0);
+
+  Result reference = run<DoublePrecision>(particles);
+  Result single = run<FloatPrecision>(particles);
+  Result mixed = run<MixedPrecision>(particles);
+
+  std::printf("%zu bodies, %d steps\n", particles.size(), BENCH_STEPS);
+  std::printf("%-8s %10s %10s %10s %12s %12s %12s %12s\n", "mode",
+              "tree ms", "direct ms", "step ms", "tree p50", "tree max",
+              "direct p50", "pos rms");
+  report("float", single, reference);
+  report("mixed", mixed, reference);
+  report("double", reference, reference);
+
+  return 0;
+}
@@ -0,0 +1,82 @@
+#include "defines.hpp"
+#include "scene.hpp"
+#include "spawns.hpp"
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+using std::vector, sf::Vector2f;
+using bench_clock = std::chrono::steady_clock;
+
+#define BENCH_GALAXIES 4
+#define BENCH_BODIES_PER_GALAXY 500000
+
+// Time to build a multi-galaxy scene and to write and read it back in both
+// file formats, checking that the bodies survive the round trip.
+
+static double elapsed_s(bench_clock::time_point start) {
+  std::chrono::duration<double> elapsed = bench_clock::now() - start;
+  return elapsed.count();
+}
+
+static bool same_bodies(const vector<Particle> &a, const vector<Particle> &b) {
+  if (a.size() != b.size()) {
+    return false;
+  }
+  for (size_t i = 0; i < a.size(); i++) {
+    if (norm(a[i].pos - b[i].pos) != 0 || norm(a[i].vel - b[i].vel) != 0 ||
+        a[i].mass != b[i].mass || a[i].radius != b[i].radius ||
+        a[i].index != b[i].index) {
+      return false;
+    }
+  }
+  return true;
+}
+
+static void round_trip(const char *name, const string &path,
+                       const vector<Particle> &particles) {
+  auto start = bench_clock::now();
+  bool saved = save_scene(path, particles);
+  double save_s = elapsed_s(start);
+
+  vector<Particle> loaded;
+  start = bench_clock::now();
+  bool read = saved && load_scene(path, loaded);
+  double load_s = elapsed_s(start);
+
+  double megabytes = saved ? fs::file_size(path) / 1e6 : 0.0;
+  std::printf("%-8s %10.1f %10.3f %10.3f %12.1f %8s\n", name, megabytes,
+              save_s, load_s, megabytes / load_s,
+              read && same_bodies(particles, loaded) ? "yes" : "NO");
+  fs::remove(path);
+}
+
+int main() {
+  vector<Galaxy> scene;
+  for (int i = 0; i < BENCH_GALAXIES; i++) {
+    float x = WIDTH * (i + 1.0) / (BENCH_GALAXIES + 1.0);
+    float vy = i % 2 == 0 ? 0.2 : -0.2;
+    scene.push_back({Vector2f(x, HEIGHT / 2.0), Vector2f(0.0, vy), 1000.0,
+                     WIDTH / (2.0f * BENCH_GALAXIES + 2.0f),
+                     BENCH_BODIES_PER_GALAXY});
+  }
+
+  vector<Particle> particles;
+  auto start = bench_clock::now();
+  spawn_scene(particles, scene);
+  double spawn_s = elapsed_s(start);
+
+  std::printf("%zu bodies in %d galaxies spawned in %.3f s on %d threads\n",
+              particles.size(), BENCH_GALAXIES, spawn_s, loader_threads());
+  std::printf("%-8s %10s %10s %10s %12s %8s\n", "format", "MB", "save s",
+              "load s", "load MB/s", "exact");
+
+  fs::path directory = fs::temp_directory_path();
+  round_trip("csv", (directory / "bench_scene.csv").string(), particles);
+  round_trip("binary", (directory / "bench_scene.bin").string(), particles);
+
+  return 0;
+}
@@ -9,8 +9,31 @@
 
 #define WIDTH 800
 #define HEIGHT 800
+// Only used when DIMENSIONS is 3.
+#define DEPTH 800
+
+// 2 - quadtree in the plane, 3 - octree, drawn projected onto the screen.
+#define DIMENSIONS 2
 
 #define RECORD_FROM_START false
 #define SHOW_BOUNDS false
+// Bodies wrap around the world box and feel its periodic images. Two
+// dimensional only.
+#define PERIODIC false
 
 #define THREADS_AMOUNT 1
+// Threads that spawn and load initial conditions, 0 for one per core.
+#define LOADER_THREADS 0
+
+// 0 - float, 1 - double, 2 - mixed (float offsets, double accumulation)
+#define PRECISION_MODE 0
+
+#define THETA 0.5
+// Up to this many bodies forces are summed directly instead of the tree,
+// around where tree build and walk at THETA 0.5 catch up on one thread.
+#define DIRECT_THRESHOLD 3500
+
+// Processes forked for a distributed run on this machine, ranks listen on
+// BASE_PORT + rank. Pass `<rank> <host:port>...` to main to span machines.
+#define PROCESSES_AMOUNT 1
+#define BASE_PORT 47000
@@ -0,0 +1,25 @@
+#pragma once
+
+#include "particle.hpp"
+#include <SFML/System/Vector3.hpp>
+
+// System-wide quantities summed while bodies are integrated, so they cost no
+// extra pass over the particles. Every thread (and every process of a
+// distributed run) fills its own and the partials are merged.
+struct Diagnostics {
+  int count;
+  double min_speed, max_speed;
+  double kinetic, potential;
+  // Sum of r . F, equals the potential energy for plain 1/r^2 gravity.
+  double virial;
+  // In two dimensions the z components are zero and angular momentum only
+  // has one.
+  sf::Vector3<double> momentum;
+  sf::Vector3<double> angular_momentum;
+
+  Diagnostics();
+  template <typename P, int D> void add(const BasicParticle<P, D> &particle);
+  void merge(const Diagnostics &other);
+  double total_energy() const;
+  double virial_ratio() const;
+};
@@ -0,0 +1,18 @@
+#pragma once
+
+#include "defines.hpp"
+#include "particle.hpp"
+#include <vector>
+
+using std::vector;
+
+// Exact O(n^2) summation, the reference for QuadTree::calc_force and the
+// faster option for small scenes. Sets netForce and potential of every
+// particle.
+template <typename P, int D>
+void calc_direct_forces(vector<BasicParticle<P, D>> &particles,
+                        int threads = THREADS_AMOUNT);
+
+// Total potential energy of the force law used by get_attraction_force.
+template <typename P, int D>
+double calc_direct_potential(vector<BasicParticle<P, D>> &particles);
@@ -0,0 +1,33 @@
+#pragma once
+
+#include "diagnostics.hpp"
+#include "particle.hpp"
+#include "quadtree.hpp"
+#include "transport.hpp"
+#include <cstdint>
+#include <vector>
+
+using std::vector;
+
+// Splits the bodies between the processes of a transport along a Morton
+// curve, weighted by the work each body took in the previous step. Every
+// step each process sends the others the part of its tree they need
+// (locally essential tree) and integrates only its own bodies.
+class Domain {
+public:
+  vector<Particle> local;
+
+  Domain(Transport &_transport);
+  bool sync(bool running);
+  void step(Diagnostics &diagnostics);
+  void gather(vector<Particle> &particles);
+  void run_worker();
+
+private:
+  Transport &transport;
+
+  void rebalance();
+  vector<Particle> exchange_essential(QuadTree &qt);
+};
+
+uint32_t morton_key(const Particle &particle);
@@ -1,5 +1,6 @@
 #pragma once
 
+#include "diagnostics.hpp"
 #include "particle.hpp"
 #include "quadtree.hpp"
 #include <vector>
@@ -8,10 +9,14 @@
 
 using std::vector, std::string, sf::Clock, sf::Time, sf::RenderWindow;
 
-void calc_new_pos(Particle &particle, QuadTree &qt);
+template <typename P, int D>
+void calc_new_pos(BasicParticle<P, D> &particle, BasicQuadTree<P, D> &qt,
+                  Diagnostics &diagnostics);
+template <typename P, int D>
+void apply_force(BasicParticle<P, D> &particle, Diagnostics &diagnostics);
 void calc_avg_vel(float &min_vel_avg, float &max_vel_avg,
-                  vector<Particle> particles, int frame_cnt);
+                  Diagnostics &diagnostics, int frame_cnt);
 void update_title(Clock &clock, Time &elapsed, RenderWindow &window,
-                  int &frame_cnt_second);
+                  int &frame_cnt_second, Diagnostics &diagnostics);
 void save_video(string &ffmpeg_command);
 void save_screen(RenderWindow &window, int &frame_cnt);
@@ -1,18 +1,45 @@
 #pragma once
 
+#include "defines.hpp"
+#include "precision.hpp"
+#include "utils.hpp"
 #include <SFML/Graphics.hpp>
 
-class Particle {
+// A body in D dimensions, D is 2 or 3.
+template <typename P, int D = DIMENSIONS> class BasicParticle {
 public:
-  sf::Vector2f pos, vel, netForce;
-  float mass, radius;
+  using storage_t = typename P::storage_t;
+  using compute_t = typename P::compute_t;
+  using accum_t = typename P::accum_t;
+  using vec_t = VectorN<D, storage_t>;
+  using force_t = VectorN<D, accum_t>;
+
+  vec_t pos, vel;
+  force_t netForce;
+  // Potential energy against everything netForce was summed over.
+  accum_t potential;
+  storage_t mass, radius;
   int index;
+  // Interactions evaluated for this particle in the last force pass.
+  int work;
+
+  BasicParticle();
+  BasicParticle(vec_t _pos, vec_t _vel, storage_t _mass, storage_t _radius,
+                int _index);
+  template <typename Q>
+  explicit BasicParticle(const BasicParticle<Q, D> &other)
+      : pos(other.pos), vel(other.vel), netForce(other.netForce),
+        potential(other.potential), mass(other.mass), radius(other.radius),
+        index(other.index), work(other.work) {}
 
-  Particle();
-  Particle(sf::Vector2f _pos, sf::Vector2f _vel, float _mass, float _radius,
-           int _index);
-  sf::Vector2f get_attraction_force(const Particle *anotherParticle);
-  float get_distance_to(sf::Vector2f object);
+  force_t get_attraction_force(const vec_t &other_pos, storage_t other_mass,
+                               accum_t &potential_sum);
+  storage_t get_distance_to(vec_t object);
+  // Offset to the closest periodic image of object when PERIODIC is set.
+  vec_t nearest_offset(const vec_t &object);
   sf::Color get_color(float value, sf::Color &left, sf::Color &right);
+  // Three dimensional bodies are drawn projected onto the xy plane.
   void show(sf::RenderWindow &window, float minVel, float maxVel);
 };
+
+using Particle = BasicParticle<Precision>;
@@ -0,0 +1,90 @@
+#pragma once
+
+#include "defines.hpp"
+#include "utils.hpp"
+#include <SFML/System/Vector2.hpp>
+#include <algorithm>
+#include <cmath>
+
+// Octree cells straddling the half box plane have no single nearest image and
+// there is no three dimensional correction table, so a periodic octree would
+// be badly wrong rather than approximate.
+static_assert(!PERIODIC || DIMENSIONS == 2,
+              "PERIODIC is only supported with DIMENSIONS 2");
+
+// Nearest periodic image of an offset between two points of a box of the
+// given length along an axis, so |offset| < length. Selects rather than
+// floor(), which only vectorizes without trapping math.
+template <typename T> T wrap_offset(T offset, T length) {
+  offset -= offset > length / 2 ? length : T(0);
+  offset += offset < -length / 2 ? length : T(0);
+  return offset;
+}
+
+// Position folded back into [0, length). Rounding maps a tiny negative
+// position onto length itself, which no tree cell contains, so that case
+// becomes 0.
+template <typename T> T wrap_position(T position, T length) {
+  T wrapped = position - length * std::floor(position / length);
+  return wrapped < length ? wrapped : T(0);
+}
+
+// Nearest periodic image of an offset within the world box.
+template <typename V> V wrap_offset(V offset) {
+  using T = decltype(offset.x);
+  unroll<dimensions_of<V>>([&](int k) {
+    axis(offset, k) = wrap_offset(axis(offset, k), (T)world_extent(k));
+  });
+  return offset;
+}
+
+// Position folded back into the world box.
+template <typename V> V wrap_position(V position) {
+  using T = decltype(position.x);
+  unroll<dimensions_of<V>>([&](int k) {
+    axis(position, k) = wrap_position(axis(position, k), (T)world_extent(k));
+  });
+  return position;
+}
+
+// Grid cells per half box of the correction table.
+#define EWALD_GRID 32
+
+// Pull of every periodic image of a unit mass (without G) beyond the nearest
+// one, as a function of the nearest-image offset. Summed once over square
+// shells of images on a grid covering a quarter of the box, since the
+// correction is odd in the offset along its axis and even across it.
+class EwaldTable {
+public:
+  EwaldTable();
+
+  // Bilinear lookup for a wrap_offset() offset, inline and branch free so
+  // the direct solver's loop still vectorizes around it.
+  template <typename T> sf::Vector2<T> correction(T dx, T dy) const {
+    float gx = std::abs((float)dx) * (2.0f * EWALD_GRID / WIDTH);
+    float gy = std::abs((float)dy) * (2.0f * EWALD_GRID / HEIGHT);
+    int ix = std::min((int)gx, EWALD_GRID - 1);
+    int iy = std::min((int)gy, EWALD_GRID - 1);
+    float tx = gx - ix;
+    float ty = gy - iy;
+
+    int i = iy * (EWALD_GRID + 1) + ix;
+    float x = interpolate(table_x, i, tx, ty);
+    float y = interpolate(table_y, i, tx, ty);
+    return sf::Vector2<T>(dx < 0 ? -x : x, dy < 0 ? -y : y);
+  }
+
+private:
+  // Indexed loads rather than pointer offsets, which gathers can't do.
+  static float interpolate(const float *table, int i, float tx, float ty) {
+    int below = i + EWALD_GRID + 1;
+    float top = table[i] + tx * (table[i + 1] - table[i]);
+    float bottom = table[below] + tx * (table[below + 1] - table[below]);
+    return top + ty * (bottom - top);
+  }
+
+  float table_x[(EWALD_GRID + 1) * (EWALD_GRID + 1)];
+  float table_y[(EWALD_GRID + 1) * (EWALD_GRID + 1)];
+};
+
+const EwaldTable &ewald_table();
@@ -0,0 +1,36 @@
+#pragma once
+
+#include "defines.hpp"
+
+// Precision policies shared by the particle store and the force kernels.
+//  storage_t - positions, velocities, masses and tree centres of mass
+//  compute_t - offsets between bodies/cells and the force law itself
+//  accum_t   - net force and centre of mass summation
+
+struct FloatPrecision {
+  using storage_t = float;
+  using compute_t = float;
+  using accum_t = float;
+};
+
+struct DoublePrecision {
+  using storage_t = double;
+  using compute_t = double;
+  using accum_t = double;
+};
+
+// Positions are kept in double, but every interaction is evaluated on the
+// float offset to the body/cell centre, and the results are summed in double.
+struct MixedPrecision {
+  using storage_t = double;
+  using compute_t = float;
+  using accum_t = double;
+};
+
+#if PRECISION_MODE == 1
+using Precision = DoublePrecision;
+#elif PRECISION_MODE == 2
+using Precision = MixedPrecision;
+#else
+using Precision = FloatPrecision;
+#endif
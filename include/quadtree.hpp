@@ -1,28 +1,44 @@
 #pragma once
 
+#include "defines.hpp"
 #include "rectangle.hpp"
 #include <mutex>
+#include <vector>
 #include <SFML/Graphics.hpp>
 
-class QuadTree {
+// Barnes-Hut tree with 2^D children per cell, a quadtree in two dimensions
+// and an octree in three.
+template <typename P, int D = DIMENSIONS> class BasicQuadTree {
 public:
-  Rectangle bounds;
-  std::shared_ptr<QuadTree> children[4];
-  std::shared_ptr<Particle> particle;
-  float mass;
-  sf::Vector2f m_center_pos;
+  static constexpr int children_amount = 1 << D;
+
+  using particle_t = BasicParticle<P, D>;
+  using bounds_t = BasicRectangle<D>;
+  using storage_t = typename P::storage_t;
+  using accum_t = typename P::accum_t;
+  using vec_t = typename particle_t::vec_t;
+
+  bounds_t bounds;
+  std::shared_ptr<BasicQuadTree> children[children_amount];
+  // Bodies of a leaf, more than one only in a cell below MIN_CELL_SIZE.
+  std::vector<particle_t> particles;
+  storage_t mass;
+  vec_t m_center_pos;
   std::recursive_mutex mtx;
 
-  QuadTree(Rectangle &_bounds);
-  void calc_force(Particle &calculationParticle);
-  void insert(Particle &insertParticle);
+  BasicQuadTree(bounds_t &_bounds);
+  int calc_force(particle_t &calculationParticle, float theta = THETA);
+  void insert(particle_t &insertParticle);
+  // Masses and centres of mass of all cells, once after the last insert.
+  void update_mass();
   void show(sf::RenderWindow &window, float minVel, float maxVel);
   void show(sf::RenderWindow &window, std::vector<int> &particlesToDraw,
             float minVel, float maxVel);
-  std::vector<int> query(Rectangle &rect);
+  std::vector<int> query(bounds_t &rect);
 
 private:
   bool is_divided();
   void subdivide();
-  void update_mass();
 };
+
+using QuadTree = BasicQuadTree<Precision>;
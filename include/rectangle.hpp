@@ -1,18 +1,34 @@
 #pragma once
 
 #include "particle.hpp"
+#include "utils.hpp"
 #include <SFML/Graphics.hpp>
 
-class Rectangle {
+// Axis aligned box in D dimensions, a square cell of the quadtree in two
+// and a cube cell of the octree in three.
+template <int D = DIMENSIONS> class BasicRectangle {
 public:
-  sf::Vector2f top_left_pos;
-  float w, h;
+  using vec_t = VectorN<D, float>;
 
-  Rectangle(sf::Vector2f _top_left_pos, float _w, float _h);
+  vec_t top_left_pos;
+  vec_t size;
 
-  bool contains(Particle &particle);
+  BasicRectangle(vec_t _top_left_pos, vec_t _size);
+  // The WIDTH x HEIGHT (x DEPTH) box the simulation runs in.
+  static BasicRectangle world();
 
-  bool intersects(Rectangle &rect);
+  template <typename P> bool contains(const BasicParticle<P, D> &particle) {
+    bool inside = true;
+    unroll<D>([&](int k) {
+      inside = inside && axis(top_left_pos, k) <= axis(particle.pos, k) &&
+               axis(top_left_pos, k) + axis(size, k) > axis(particle.pos, k);
+    });
+    return inside;
+  }
+
+  bool intersects(BasicRectangle &rect);
 
   void show(sf::RenderWindow &window);
 };
+
+using Rectangle = BasicRectangle<>;
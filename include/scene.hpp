@@ -0,0 +1,28 @@
+#pragma once
+
+#include "particle.hpp"
+#include "utils.hpp"
+#include <string>
+#include <vector>
+
+using std::vector, std::string;
+
+// Initial conditions files, one record per body with DIMENSIONS position
+// and velocity components, mass and radius, or a list of galaxies to spawn.
+//
+// Galaxies (*.galaxies, load only): x,y,vx,vy,sun_mass,radius,count per
+// line, the arguments of spawn_galaxy(). Text after # is a comment.
+//
+// CSV (*.csv): x,y[,z],vx,vy[,vz],mass[,radius] per line, an optional header
+// line and PARTICLE_RADIUS for a missing radius.
+//
+// Binary (anything else): "GPSC", uint32 dimensions, uint64 count, then
+// native endian doubles as structure of arrays: each position axis, each
+// velocity axis, masses and radii, count values apiece.
+//
+// Bodies are appended to particles with indices continuing from its size.
+// Files are read in chunks by several threads, each parsing straight into
+// its part of the storage, which is resized once up front.
+bool load_scene(const string &path, vector<Particle> &particles,
+                int threads = loader_threads());
+bool save_scene(const string &path, const vector<Particle> &particles);
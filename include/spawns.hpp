@@ -1,5 +1,6 @@
 #pragma once
 
+#include "defines.hpp"
 #include "particle.hpp"
 #include <vector>
 #include <SFML/Graphics.hpp>
@@ -7,8 +8,23 @@
 
 using std::vector, sf::Vector2f;
 
-void spawn_circle(vector<Particle> &particles, Vector2f center);
-void spawn_spinning_circle(vector<Particle> &particles, Vector2f center);
+// One galaxy of a scene: count bodies orbiting a sun of sun_mass within
+// radius of center, the whole galaxy moving with velocity.
+struct Galaxy {
+  Vector2f center;
+  Vector2f velocity;
+  float sun_mass;
+  float radius;
+  int count;
+};
+
+// Every spawn appends to particles, indices continue from its size.
+void spawn_circle(vector<Particle> &particles, Vector2f center,
+                  int count = PARTICLES_AMOUNT);
+void spawn_spinning_circle(vector<Particle> &particles, Vector2f center,
+                           int count = PARTICLES_AMOUNT);
 void spawn_galaxy(vector<Particle> &particles, Vector2f center,
-                  Vector2f initial_vel, float sun_mass, float radius);
-void spawn_screen(vector<Particle> &particles);
+                  Vector2f initial_vel, float sun_mass, float radius,
+                  int count = PARTICLES_AMOUNT);
+void spawn_screen(vector<Particle> &particles, int count = PARTICLES_AMOUNT);
+void spawn_scene(vector<Particle> &particles, const vector<Galaxy> &galaxies);
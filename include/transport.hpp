@@ -0,0 +1,73 @@
+#pragma once
+
+#include <cstring>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <vector>
+#include <sys/types.h>
+
+using std::vector, std::string;
+
+// Message passing between the processes of a distributed run. A process is
+// identified by its rank in [0, size()), rank 0 owns the window.
+class Transport {
+public:
+  virtual ~Transport() = default;
+  virtual int rank() = 0;
+  virtual int size() = 0;
+  virtual void send(int to, const vector<char> &data) = 0;
+  virtual vector<char> recv(int from) = 0;
+
+  // Sends outgoing[r] to every rank r and returns what each rank sent here.
+  vector<vector<char>> exchange(vector<vector<char>> &outgoing);
+};
+
+// Single process, nothing to talk to.
+class LocalTransport : public Transport {
+public:
+  int rank() override;
+  int size() override;
+  void send(int to, const vector<char> &data) override;
+  vector<char> recv(int from) override;
+};
+
+// Full mesh of TCP connections, hosts[r] is "address:port" of rank r.
+class SocketTransport : public Transport {
+public:
+  SocketTransport(int _rank, vector<string> &hosts);
+  ~SocketTransport();
+  int rank() override;
+  int size() override;
+  void send(int to, const vector<char> &data) override;
+  vector<char> recv(int from) override;
+
+  vector<pid_t> children;
+
+private:
+  int my_rank;
+  int listen_fd;
+  vector<int> peers;
+};
+
+// `main <rank> <host:port>...` joins a cluster, otherwise PROCESSES_AMOUNT
+// processes are forked and connected over loopback.
+std::unique_ptr<Transport> create_transport(int argc, char *argv[]);
+
+template <typename T> vector<char> pack(const vector<T> &items) {
+  static_assert(std::is_trivially_copyable_v<T>);
+  vector<char> data(items.size() * sizeof(T));
+  if (!items.empty()) {
+    std::memcpy(data.data(), items.data(), data.size());
+  }
+  return data;
+}
+
+template <typename T> void unpack(const vector<char> &data, vector<T> &items) {
+  static_assert(std::is_trivially_copyable_v<T>);
+  size_t offset = items.size();
+  items.resize(offset + data.size() / sizeof(T));
+  if (!data.empty()) {
+    std::memcpy(items.data() + offset, data.data(), data.size());
+  }
+}
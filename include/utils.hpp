@@ -1,12 +1,138 @@
 #pragma once
 
+#include "defines.hpp"
 #include <SFML/Graphics.hpp>
+#include <SFML/System/Vector3.hpp>
+#include <algorithm>
+#include <cmath>
+#include <future>
+#include <random>
+#include <type_traits>
+#include <utility>
 #include <vector>
 
-float distance(const sf::Vector2f &point1, const sf::Vector2f &point2);
-float norm(const sf::Vector2f &vector);
-sf::Vector2f normalize(const sf::Vector2f &vector);
-sf::Vector2f random_in_circle(float radius, float padding, sf::Vector2f center);
-sf::Vector2f random_on_screen();
-sf::Vector2f random_speed();
+// Vector of a simulation in D dimensions.
+template <int D, typename T>
+using VectorN = std::conditional_t<D == 3, sf::Vector3<T>, sf::Vector2<T>>;
+
+template <typename V> constexpr int dimensions_of = 2;
+template <typename T> constexpr int dimensions_of<sf::Vector3<T>> = 3;
+
+// Component k of a vector, so loops over axes work in any dimension.
+template <typename T> T &axis(sf::Vector2<T> &vector, int k) {
+  return k == 0 ? vector.x : vector.y;
+}
+template <typename T> T axis(const sf::Vector2<T> &vector, int k) {
+  return k == 0 ? vector.x : vector.y;
+}
+template <typename T> T &axis(sf::Vector3<T> &vector, int k) {
+  return k == 0 ? vector.x : k == 1 ? vector.y : vector.z;
+}
+template <typename T> T axis(const sf::Vector3<T> &vector, int k) {
+  return k == 0 ? vector.x : k == 1 ? vector.y : vector.z;
+}
+
+// Calls f(0) ... f(N - 1), unrolled at compile time.
+template <int N, typename F> void unroll(F &&f) {
+  [&]<int... I>(std::integer_sequence<int, I...>) {
+    (f(I), ...);
+  }(std::make_integer_sequence<int, N>());
+}
+
+// Size of the world along axis k, DEPTH is only used in three dimensions.
+constexpr float world_extent(int k) {
+  return k == 0 ? WIDTH : k == 1 ? HEIGHT : DEPTH;
+}
+
+template <typename T>
+T dot(const sf::Vector2<T> &vector1, const sf::Vector2<T> &vector2) {
+  return vector1.x * vector2.x + vector1.y * vector2.y;
+}
+
+template <typename T>
+T dot(const sf::Vector3<T> &vector1, const sf::Vector3<T> &vector2) {
+  return vector1.x * vector2.x + vector1.y * vector2.y + vector1.z * vector2.z;
+}
+
+template <typename T>
+sf::Vector3<T> cross(const sf::Vector3<T> &vector1,
+                     const sf::Vector3<T> &vector2) {
+  return sf::Vector3<T>(vector1.y * vector2.z - vector1.z * vector2.y,
+                        vector1.z * vector2.x - vector1.x * vector2.z,
+                        vector1.x * vector2.y - vector1.y * vector2.x);
+}
+
+template <typename V> auto norm(const V &vector) {
+  return std::sqrt(dot(vector, vector));
+}
+
+template <typename V> auto distance(const V &point1, const V &point2) {
+  return norm(point1 - point2);
+}
+
+template <typename V> V normalize(const V &vector) {
+  auto length = norm(vector);
+
+  if (length != 0) {
+    return vector / length;
+  } else {
+    return vector;
+  }
+}
+
+// Any vector as a double one in three dimensions, zero along missing axes.
+template <typename V> sf::Vector3<double> extend(const V &vector) {
+  sf::Vector3<double> extended(0.0, 0.0, 0.0);
+  unroll<dimensions_of<V>>([&](int k) { axis(extended, k) = axis(vector, k); });
+  return extended;
+}
+
+// A point of the screen plane as V, at depth z when V is three dimensional.
+template <typename V> V lift(const sf::Vector2f &point, float z = 0.0f) {
+  V lifted;
+  lifted.x = point.x;
+  lifted.y = point.y;
+  if constexpr (dimensions_of<V> == 3) {
+    lifted.z = z;
+  }
+  return lifted;
+}
+
+// Arctangent for x >= 0 within ~1e-5 rad, branch free so the force kernels
+// still vectorize when they sum potential energy.
+template <typename T> inline T atan_positive(T x) {
+  bool inverted = x > 1;
+  T z = inverted ? 1 / x : x;
+  T z_sq = z * z;
+  T p = z * (T(0.99997726) +
+             z_sq * (T(-0.33262347) +
+                     z_sq * (T(0.19354346) +
+                             z_sq * (T(-0.11643287) +
+                                     z_sq * (T(0.05265332) +
+                                             z_sq * T(-0.01172120))))));
+  return inverted ? T(M_PI / 2.0) - p : p;
+}
+
+// Runs f(begin, end) over [0, count) split into one chunk per thread.
+template <typename F> void parallel_chunks(size_t count, int threads, F f) {
+  threads = std::max(1, std::min<int>(threads, count));
+  size_t chunk_size = (count + threads - 1) / threads;
+  std::vector<std::future<void>> futures;
+  for (size_t start = 0; start < count; start += chunk_size) {
+    futures.emplace_back(std::async(std::launch::async, f, start,
+                                    std::min(start + chunk_size, count)));
+  }
+  for (auto &future : futures) {
+    future.get();
+  }
+}
+
+// Threads to generate and load initial conditions with, see LOADER_THREADS.
+int loader_threads();
+
+sf::Vector2f random_in_circle(float radius, float padding, sf::Vector2f center,
+                              std::mt19937 &gen);
+sf::Vector2f random_on_screen(std::mt19937 &gen);
+sf::Vector2f random_speed(std::mt19937 &gen);
+float random_depth(std::mt19937 &gen);
 sf::Color multi_color_lerp(std::vector<sf::Color> &colors, float t);
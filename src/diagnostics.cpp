@@ -0,0 +1,67 @@
+#include "diagnostics.hpp"
+#include "defines.hpp"
+#include "utils.hpp"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+Diagnostics::Diagnostics() {
+  count = 0;
+  min_speed = std::numeric_limits<double>::infinity();
+  max_speed = 0.0;
+  kinetic = 0.0;
+  potential = 0.0;
+  virial = 0.0;
+  momentum = sf::Vector3<double>(0.0, 0.0, 0.0);
+  angular_momentum = sf::Vector3<double>(0.0, 0.0, 0.0);
+}
+
+template <typename P, int D>
+void Diagnostics::add(const BasicParticle<P, D> &particle) {
+  double mass = particle.mass;
+  sf::Vector3<double> vel = extend(particle.vel);
+  double speed_sq = dot(vel, vel);
+  double speed = std::sqrt(speed_sq);
+
+  // Positions relative to the world centre, angular momentum is about it.
+  sf::Vector3<double> pos = extend(particle.pos);
+  unroll<D>([&](int k) { axis(pos, k) -= world_extent(k) / 2.0; });
+
+  count++;
+  min_speed = std::min(min_speed, speed);
+  max_speed = std::max(max_speed, speed);
+  kinetic += 0.5 * mass * speed_sq;
+  // Every pair is in the potential of both of its bodies.
+  potential += 0.5 * (double)particle.potential;
+  virial += dot(pos, extend(particle.netForce));
+  momentum += vel * mass;
+  angular_momentum += cross(pos, vel) * mass;
+}
+
+void Diagnostics::merge(const Diagnostics &other) {
+  count += other.count;
+  min_speed = std::min(min_speed, other.min_speed);
+  max_speed = std::max(max_speed, other.max_speed);
+  kinetic += other.kinetic;
+  potential += other.potential;
+  virial += other.virial;
+  momentum += other.momentum;
+  angular_momentum += other.angular_momentum;
+}
+
+double Diagnostics::total_energy() const { return kinetic + potential; }
+
+// 2K / |W|, 1 for a system in virial equilibrium.
+double Diagnostics::virial_ratio() const {
+  if (virial == 0.0) {
+    return 0.0;
+  }
+  return 2.0 * kinetic / std::abs(virial);
+}
+
+template void Diagnostics::add(const BasicParticle<FloatPrecision, 2> &);
+template void Diagnostics::add(const BasicParticle<DoublePrecision, 2> &);
+template void Diagnostics::add(const BasicParticle<MixedPrecision, 2> &);
+template void Diagnostics::add(const BasicParticle<FloatPrecision, 3> &);
+template void Diagnostics::add(const BasicParticle<DoublePrecision, 3> &);
+template void Diagnostics::add(const BasicParticle<MixedPrecision, 3> &);
@@ -0,0 +1,178 @@
+#include "direct.hpp"
+#include "periodic.hpp"
+#include "utils.hpp"
+#include <algorithm>
+#include <cmath>
+#include <future>
+
+// Sources per tile, coordinates and mass of a tile take 6 KiB in float (8 KiB
+// in three dimensions) and stay in L1 while every target of a thread's range
+// runs over them.
+#define DIRECT_TILE 512
+
+// Pull and potential of one tile of sources on the body at (xi, yi, zi),
+// without G, the body's own mass and, for the potential, the -1/softening
+// factor. zs and zi are only read in three dimensions. In PERIODIC mode the
+// pull includes all images, the potential only the nearest one.
+// Offsets are taken in the storage type S and only then cast to the compute
+// type T, the tile is summed in the accumulation type A, as everywhere else
+// in mixed precision.
+// Branch free so the loop vectorizes; a body on top of another (or itself)
+// contributes nothing, like normalize() of a zero offset.
+template <int D, typename S, typename T, typename A>
+static void sum_tile(const S *xs, const S *ys, const S *zs, const T *masses,
+                     size_t count, S xi, S yi, S zi, A *force_out,
+                     A &potential_out) {
+  const T softening = SOFTENING;
+  const T softening_sq = SOFTENING * SOFTENING;
+  const EwaldTable *ewald = PERIODIC ? &ewald_table() : nullptr;
+  A fx = 0.0;
+  A fy = 0.0;
+  A fz = 0.0;
+  A potential = 0.0;
+
+#pragma omp simd reduction(+ : fx, fy, fz, potential)
+  for (size_t j = 0; j < count; j++) {
+    T dx = (T)(xs[j] - xi);
+    T dy = (T)(ys[j] - yi);
+    T dz = 0.0;
+    if constexpr (D == 3) {
+      dz = (T)(zs[j] - zi);
+    }
+    sf::Vector2<T> correction(0.0, 0.0);
+    if (PERIODIC) {
+      dx = wrap_offset(dx, (T)WIDTH);
+      dy = wrap_offset(dy, (T)HEIGHT);
+      if constexpr (D == 3) {
+        dz = wrap_offset(dz, (T)DEPTH);
+      } else {
+        correction = ewald->correction(dx, dy);
+      }
+    }
+    T dist_sq = dx * dx + dy * dy;
+    if constexpr (D == 3) {
+      dist_sq += dz * dz;
+    }
+    T inv_dist = dist_sq > 0 ? 1 / std::sqrt(dist_sq) : 0;
+    T magnitude = masses[j] * inv_dist / (dist_sq + softening_sq);
+    T pull_x = dx * magnitude;
+    T pull_y = dy * magnitude;
+    if (PERIODIC) {
+      pull_x += masses[j] * correction.x;
+      pull_y += masses[j] * correction.y;
+    }
+    fx += pull_x;
+    fy += pull_y;
+    if constexpr (D == 3) {
+      fz += dz * magnitude;
+    }
+    potential += masses[j] * atan_positive(softening * inv_dist);
+  }
+
+  force_out[0] = fx;
+  force_out[1] = fy;
+  force_out[2] = fz;
+  potential_out = potential;
+}
+
+template <typename P, int D>
+void calc_direct_forces(vector<BasicParticle<P, D>> &particles, int threads) {
+  using storage_t = typename P::storage_t;
+  using compute_t = typename P::compute_t;
+  using accum_t = typename P::accum_t;
+  using force_t = typename BasicParticle<P, D>::force_t;
+
+  size_t n = particles.size();
+  if (n == 0) {
+    return;
+  }
+
+  // Structure of arrays relative to the world centre, so the inner loop
+  // streams contiguous values.
+  vector<storage_t> coords[3];
+  vector<compute_t> masses(n);
+  for (int k = 0; k < D; k++) {
+    coords[k].resize(n);
+  }
+  for (size_t i = 0; i < n; i++) {
+    unroll<D>([&](int k) {
+      coords[k][i] = (storage_t)(axis(particles[i].pos, k) -
+                                 world_extent(k) / 2.0);
+    });
+    masses[i] = (compute_t)particles[i].mass;
+  }
+
+  vector<force_t> forces(n);
+  vector<accum_t> potentials(n, 0.0);
+  auto sum_range = [&](size_t begin, size_t end) {
+    for (size_t tile = 0; tile < n; tile += DIRECT_TILE) {
+      size_t tile_end = std::min(tile + DIRECT_TILE, n);
+      const storage_t *zs = D == 3 ? coords[2].data() + tile : nullptr;
+      for (size_t i = begin; i < end; i++) {
+        accum_t force[3], potential;
+        sum_tile<D>(coords[0].data() + tile, coords[1].data() + tile, zs,
+                    masses.data() + tile, tile_end - tile, coords[0][i],
+                    coords[1][i], D == 3 ? coords[2][i] : 0, force, potential);
+        unroll<D>([&](int k) { axis(forces[i], k) += force[k]; });
+        potentials[i] += potential;
+      }
+    }
+  };
+
+  threads = std::max(1, std::min<int>(threads, n));
+  size_t chunk_size = (n + threads - 1) / threads;
+  vector<std::future<void>> futures;
+  for (size_t start = 0; start < n; start += chunk_size) {
+    futures.emplace_back(std::async(std::launch::async, sum_range, start,
+                                    std::min(start + chunk_size, n)));
+  }
+  for (auto &f : futures) {
+    f.get();
+  }
+
+  for (size_t i = 0; i < n; i++) {
+    accum_t scale = (accum_t)G_CONST * (accum_t)particles[i].mass;
+    particles[i].netForce = forces[i] * scale;
+    particles[i].potential = -potentials[i] * scale / (accum_t)SOFTENING;
+  }
+}
+
+template <typename P, int D>
+double calc_direct_potential(vector<BasicParticle<P, D>> &particles) {
+  // F(r) = G m1 m2 / (r^2 + s^2) integrated from r to infinity.
+  double potential = 0.0;
+  for (size_t i = 0; i < particles.size(); i++) {
+    for (size_t j = i + 1; j < particles.size(); j++) {
+      double r = distance(extend(particles[j].pos), extend(particles[i].pos));
+      potential -= G_CONST * particles[i].mass * particles[j].mass /
+                   SOFTENING * (M_PI / 2.0 - std::atan(r / SOFTENING));
+    }
+  }
+  return potential;
+}
+
+template void calc_direct_forces(vector<BasicParticle<FloatPrecision, 2>> &,
+                                 int);
+template void calc_direct_forces(vector<BasicParticle<DoublePrecision, 2>> &,
+                                 int);
+template void calc_direct_forces(vector<BasicParticle<MixedPrecision, 2>> &,
+                                 int);
+template void calc_direct_forces(vector<BasicParticle<FloatPrecision, 3>> &,
+                                 int);
+template void calc_direct_forces(vector<BasicParticle<DoublePrecision, 3>> &,
+                                 int);
+template void calc_direct_forces(vector<BasicParticle<MixedPrecision, 3>> &,
+                                 int);
+
+template double
+calc_direct_potential(vector<BasicParticle<FloatPrecision, 2>> &);
+template double
+calc_direct_potential(vector<BasicParticle<DoublePrecision, 2>> &);
+template double
+calc_direct_potential(vector<BasicParticle<MixedPrecision, 2>> &);
+template double
+calc_direct_potential(vector<BasicParticle<FloatPrecision, 3>> &);
+template double
+calc_direct_potential(vector<BasicParticle<DoublePrecision, 3>> &);
+template double
+calc_direct_potential(vector<BasicParticle<MixedPrecision, 3>> &);
@@ -0,0 +1,232 @@
+#include "domain.hpp"
+#include "defines.hpp"
+#include "helpers.hpp"
+#include "periodic.hpp"
+#include "rectangle.hpp"
+#include "utils.hpp"
+#include <algorithm>
+#include <cmath>
+
+#define DOMAIN_BIN_BITS 12
+// Bits per axis of a Morton key, 16 in two dimensions and 10 in three.
+#define MORTON_BITS (32 / DIMENSIONS)
+
+uint32_t morton_key(const Particle &particle) {
+  uint32_t key = 0;
+  unroll<DIMENSIONS>([&](int k) {
+    float t = std::clamp((float)axis(particle.pos, k) / world_extent(k), 0.0f,
+                         1.0f);
+    uint32_t cell = t * ((1u << MORTON_BITS) - 1);
+    for (int bit = 0; bit < MORTON_BITS; bit++) {
+      key |= ((cell >> bit) & 1u) << (bit * DIMENSIONS + k);
+    }
+  });
+  return key;
+}
+
+static void collect_essential(QuadTree &node, Rectangle &box,
+                              vector<Particle> &essential) {
+  if (node.children[0] == nullptr) {
+    essential.insert(essential.end(), node.particles.begin(),
+                     node.particles.end());
+    return;
+  }
+
+  // Closest any body of the remote domain can get to this centre of mass.
+  Rectangle::vec_t offset = Rectangle::vec_t(node.m_center_pos) -
+                            (box.top_left_pos + box.size / 2.0f);
+  if (PERIODIC) {
+    offset = wrap_offset(offset);
+  }
+  float dist_sq = 0.0f;
+  unroll<DIMENSIONS>([&](int k) {
+    float gap = std::max(std::abs(axis(offset, k)) - axis(box.size, k) / 2.0f,
+                         0.0f);
+    dist_sq += gap * gap;
+  });
+  float dist = std::sqrt(dist_sq);
+
+  if (dist > 0.0 && node.bounds.size.x / dist < THETA) {
+    essential.push_back(
+        Particle(node.m_center_pos, Particle::vec_t(), node.mass, 1.0, -1));
+    return;
+  }
+
+  for (auto &child : node.children) {
+    collect_essential(*child, box, essential);
+  }
+}
+
+Domain::Domain(Transport &_transport) : transport(_transport) {}
+
+bool Domain::sync(bool running) {
+  vector<vector<char>> outgoing(transport.size());
+  if (transport.rank() == 0) {
+    for (auto &message : outgoing) {
+      message.push_back(running);
+    }
+  }
+  vector<vector<char>> incoming = transport.exchange(outgoing);
+  return incoming[0][0];
+}
+
+void Domain::step(Diagnostics &diagnostics) {
+  rebalance();
+
+  Rectangle bounds = Rectangle::world();
+  QuadTree qt(bounds);
+  for (auto &particle : local) {
+    qt.insert(particle);
+  }
+  qt.update_mass();
+
+  vector<Particle> imported = exchange_essential(qt);
+  for (auto &particle : imported) {
+    qt.insert(particle);
+  }
+  qt.update_mass();
+
+  Diagnostics partial;
+  for (auto &particle : local) {
+    calc_new_pos(particle, qt, partial);
+  }
+
+  vector<vector<char>> outgoing(transport.size());
+  outgoing[0] = pack(vector<Diagnostics>{partial});
+  vector<vector<char>> incoming = transport.exchange(outgoing);
+
+  diagnostics = Diagnostics();
+  for (auto &message : incoming) {
+    vector<Diagnostics> partials;
+    unpack(message, partials);
+    for (auto &received : partials) {
+      diagnostics.merge(received);
+    }
+  }
+}
+
+void Domain::gather(vector<Particle> &particles) {
+  vector<vector<char>> outgoing(transport.size());
+  outgoing[0] = pack(local);
+  vector<vector<char>> incoming = transport.exchange(outgoing);
+
+  if (transport.rank() == 0) {
+    particles.clear();
+    for (auto &message : incoming) {
+      unpack(message, particles);
+    }
+  }
+}
+
+void Domain::run_worker() {
+  vector<Particle> unused;
+  Diagnostics diagnostics;
+  while (sync(true)) {
+    step(diagnostics);
+    gather(unused);
+  }
+}
+
+void Domain::rebalance() {
+  int n = transport.size();
+  int bins = 1 << DOMAIN_BIN_BITS;
+  int shift = MORTON_BITS * DIMENSIONS - DOMAIN_BIN_BITS;
+
+  vector<double> histogram(bins, 0.0);
+  for (auto &particle : local) {
+    histogram[morton_key(particle) >> shift] += std::max(particle.work, 1);
+  }
+
+  vector<vector<char>> outgoing(n, pack(histogram));
+  vector<vector<char>> incoming = transport.exchange(outgoing);
+
+  // Every rank sums the same histograms in the same order, so all of them
+  // agree on the split points without another round trip.
+  vector<double> total(bins, 0.0);
+  for (auto &message : incoming) {
+    vector<double> partial;
+    unpack(message, partial);
+    for (int i = 0; i < bins; i++) {
+      total[i] += partial[i];
+    }
+  }
+
+  double total_work = 0.0;
+  for (double work : total) {
+    total_work += work;
+  }
+  double target = total_work / n;
+
+  vector<int> owner(bins, 0);
+  double work_before = 0.0;
+  for (int i = 0; i < bins && target > 0.0; i++) {
+    int rank = (work_before + total[i] / 2.0) / target;
+    owner[i] = std::min(rank, n - 1);
+    work_before += total[i];
+  }
+
+  vector<vector<Particle>> buckets(n);
+  for (auto &particle : local) {
+    buckets[owner[morton_key(particle) >> shift]].push_back(particle);
+  }
+
+  for (int i = 0; i < n; i++) {
+    outgoing[i] = pack(buckets[i]);
+  }
+  incoming = transport.exchange(outgoing);
+
+  local.clear();
+  for (auto &message : incoming) {
+    unpack(message, local);
+  }
+}
+
+vector<Particle> Domain::exchange_essential(QuadTree &qt) {
+  int n = transport.size();
+
+  // Corner then size of the box around the local bodies.
+  vector<float> box;
+  if (!local.empty()) {
+    Rectangle::vec_t low(local[0].pos), high(local[0].pos);
+    for (auto &particle : local) {
+      unroll<DIMENSIONS>([&](int k) {
+        axis(low, k) = std::min(axis(low, k), (float)axis(particle.pos, k));
+        axis(high, k) = std::max(axis(high, k), (float)axis(particle.pos, k));
+      });
+    }
+    box.resize(2 * DIMENSIONS);
+    unroll<DIMENSIONS>([&](int k) {
+      box[k] = axis(low, k);
+      box[DIMENSIONS + k] = axis(high, k) - axis(low, k);
+    });
+  }
+
+  vector<vector<char>> outgoing(n, pack(box));
+  vector<vector<char>> incoming = transport.exchange(outgoing);
+
+  for (int i = 0; i < n; i++) {
+    outgoing[i].clear();
+    if (i == transport.rank() || incoming[i].empty()) {
+      continue;
+    }
+    vector<float> remote;
+    unpack(incoming[i], remote);
+    Rectangle::vec_t corner, size;
+    unroll<DIMENSIONS>([&](int k) {
+      axis(corner, k) = remote[k];
+      axis(size, k) = remote[DIMENSIONS + k];
+    });
+    Rectangle remote_box(corner, size);
+
+    vector<Particle> essential;
+    collect_essential(qt, remote_box, essential);
+    outgoing[i] = pack(essential);
+  }
+  incoming = transport.exchange(outgoing);
+
+  vector<Particle> imported;
+  for (auto &message : incoming) {
+    unpack(message, imported);
+  }
+  return imported;
+}
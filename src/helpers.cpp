@@ -1,6 +1,8 @@
 #include "helpers.hpp"
 #include "SFML/System/Vector2.hpp"
+#include "periodic.hpp"
 #include "utils.hpp"
+#include <cstdio>
 #include <filesystem>
 #include <iostream>
 
@@ -9,28 +11,60 @@ namespace fs = std::filesystem;
 using sf::Vector2f, sf::Texture, sf::Clock, sf::Time, sf::RenderWindow,
     std::to_string;
 
-void calc_new_pos(Particle &particle, QuadTree &qt) {
-  particle.netForce = Vector2f(0.0, 0.0);
-  qt.calc_force(particle);
+template <typename P, int D>
+void calc_new_pos(BasicParticle<P, D> &particle, BasicQuadTree<P, D> &qt,
+                  Diagnostics &diagnostics) {
+  using force_t = typename BasicParticle<P, D>::force_t;
 
-  Vector2f acceleration = particle.netForce / particle.mass;
+  particle.netForce = force_t();
+  particle.potential = 0.0;
+  particle.work = qt.calc_force(particle);
+
+  apply_force(particle, diagnostics);
+}
+
+template <typename P, int D>
+void apply_force(BasicParticle<P, D> &particle, Diagnostics &diagnostics) {
+  using vec_t = typename BasicParticle<P, D>::vec_t;
+  using accum_t = typename P::accum_t;
+
+  vec_t acceleration(particle.netForce / (accum_t)particle.mass);
   particle.vel += acceleration;
+  // Forces and potential belong to the position before the drift.
+  diagnostics.add(particle);
   particle.pos += particle.vel;
+
+  if (PERIODIC) {
+    particle.pos = wrap_position(particle.pos);
+  }
 }
 
-void calc_avg_vel(float &min_vel_avg, float &max_vel_avg,
-                  vector<Particle> particles, int frame_cnt) {
-  float max_vel = norm(particles[0].vel);
-  float min_vel = norm(particles[0].vel);
+template void calc_new_pos(BasicParticle<FloatPrecision, 2> &,
+                           BasicQuadTree<FloatPrecision, 2> &, Diagnostics &);
+template void calc_new_pos(BasicParticle<DoublePrecision, 2> &,
+                           BasicQuadTree<DoublePrecision, 2> &, Diagnostics &);
+template void calc_new_pos(BasicParticle<MixedPrecision, 2> &,
+                           BasicQuadTree<MixedPrecision, 2> &, Diagnostics &);
+template void calc_new_pos(BasicParticle<FloatPrecision, 3> &,
+                           BasicQuadTree<FloatPrecision, 3> &, Diagnostics &);
+template void calc_new_pos(BasicParticle<DoublePrecision, 3> &,
+                           BasicQuadTree<DoublePrecision, 3> &, Diagnostics &);
+template void calc_new_pos(BasicParticle<MixedPrecision, 3> &,
+                           BasicQuadTree<MixedPrecision, 3> &, Diagnostics &);
+template void apply_force(BasicParticle<FloatPrecision, 2> &, Diagnostics &);
+template void apply_force(BasicParticle<DoublePrecision, 2> &, Diagnostics &);
+template void apply_force(BasicParticle<MixedPrecision, 2> &, Diagnostics &);
+template void apply_force(BasicParticle<FloatPrecision, 3> &, Diagnostics &);
+template void apply_force(BasicParticle<DoublePrecision, 3> &, Diagnostics &);
+template void apply_force(BasicParticle<MixedPrecision, 3> &, Diagnostics &);
 
-  for (int i = 0; i < particles.size(); i++) {
-    if (norm(particles[i].vel) > max_vel) {
-      max_vel = norm(particles[i].vel);
-    }
-    if (norm(particles[i].vel) < min_vel) {
-      min_vel = norm(particles[i].vel);
-    }
+void calc_avg_vel(float &min_vel_avg, float &max_vel_avg,
+                  Diagnostics &diagnostics, int frame_cnt) {
+  if (diagnostics.count == 0) {
+    return;
   }
+  float max_vel = diagnostics.max_speed;
+  float min_vel = diagnostics.min_speed;
 
   max_vel_avg =
       (max_vel_avg * (float)frame_cnt + max_vel) / ((float)frame_cnt + 1.0);
@@ -39,7 +73,7 @@ void calc_avg_vel(float &min_vel_avg, float &max_vel_avg,
 }
 
 void update_title(Clock &clock, Time &elapsed, RenderWindow &window,
-                  int &frame_cnt_second) {
+                  int &frame_cnt_second, Diagnostics &diagnostics) {
   elapsed = clock.getElapsedTime();
 
   if (elapsed.asSeconds() >= 1.0) {
@@ -47,7 +81,25 @@ void update_title(Clock &clock, Time &elapsed, RenderWindow &window,
     frame_cnt_second = 0;
     clock.restart();
 
-    string title = "FPS: " + to_string(fps);
+    char metrics[160];
+    if (DIMENSIONS == 3) {
+      std::snprintf(
+          metrics, sizeof(metrics),
+          " | E: %.4g | Q: %.3f | P: (%.3g, %.3g, %.3g) | L: (%.4g, %.4g, "
+          "%.4g)",
+          diagnostics.total_energy(), diagnostics.virial_ratio(),
+          diagnostics.momentum.x, diagnostics.momentum.y,
+          diagnostics.momentum.z, diagnostics.angular_momentum.x,
+          diagnostics.angular_momentum.y, diagnostics.angular_momentum.z);
+    } else {
+      std::snprintf(metrics, sizeof(metrics),
+                    " | E: %.4g | Q: %.3f | P: (%.3g, %.3g) | L: %.4g",
+                    diagnostics.total_energy(), diagnostics.virial_ratio(),
+                    diagnostics.momentum.x, diagnostics.momentum.y,
+                    diagnostics.angular_momentum.z);
+    }
+
+    string title = "FPS: " + to_string(fps) + metrics;
     window.setTitle(title);
   }
 }
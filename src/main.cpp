@@ -2,10 +2,14 @@
 #include "SFML/System/Vector2.hpp"
 #include "SFML/Window/Keyboard.hpp"
 #include "defines.hpp"
+#include "direct.hpp"
+#include "domain.hpp"
 #include "helpers.hpp"
 #include "quadtree.hpp"
 #include "rectangle.hpp"
+#include "scene.hpp"
 #include "spawns.hpp"
+#include "transport.hpp"
 #include <SFML/Graphics.hpp>
 #include <filesystem>
 #include <future>
@@ -47,7 +51,131 @@ void worker(QuadTree &qt) {
   }
 }
 
-int main() {
+void build_tree(vector<Particle> &particles, QuadTree &qt) {
+  // for (int i = 0; i < particles.size(); i++) {
+  //   qt.insert(particles[i]);
+  // }
+
+  // size_t chunk_size =
+  //     (particles.size() + THREADS_AMOUNT - 1) / THREADS_AMOUNT;
+  //
+  // vector<std::thread> threads;
+  //
+  // for (int i = 0; i < particles.size(); i++) {
+  //   qt.insert(particles[i]);
+  // }
+  //
+  // for (unsigned int i = 0; i < THREADS_AMOUNT; ++i) {
+  //   size_t start = i * chunk_size;
+  //   size_t end = std::min(start + chunk_size, particles.size());
+  //   if (start >= end)
+  //     break;
+  //   threads.emplace_back(insert_particles, std::ref(qt),
+  //   std::ref(particles),
+  //                        start, end);
+  // }
+  //
+  // for (auto &t : threads) {
+  //   t.join();
+  // }
+
+  std::queue<Particle> work_queue;
+  std::mutex queue_mutex;
+
+  for (auto &particle : particles) {
+    work_queue.push(particle);
+  }
+
+  std::vector<std::future<void>> futures;
+  for (unsigned int i = 0; i < THREADS_AMOUNT; ++i) {
+    futures.emplace_back(std::async(std::launch::async, [&]() {
+      while (true) {
+        Particle particle;
+        {
+          // std::lock_guard<std::mutex> lock(queue_mutex);
+          // if (work_queue.empty())
+          //   break;
+          // particle = work_queue.front();
+          // work_queue.pop();
+          {
+            std::lock_guard<std::mutex> guard(queue_mutex);
+            if (work_queue.empty())
+              break;
+            particle = std::move(work_queue.front());
+            work_queue.pop();
+          }
+        }
+        qt.insert(particle);
+      }
+    }));
+  }
+
+  for (auto &f : futures) {
+    f.get();
+  }
+  qt.update_mass();
+}
+
+void step_local(vector<Particle> &particles, QuadTree &qt,
+                Diagnostics &diagnostics) {
+  bool direct = particles.size() <= DIRECT_THRESHOLD;
+  if (direct) {
+    calc_direct_forces(particles);
+  } else {
+    build_tree(particles, qt);
+  }
+
+  size_t chunk_size = (particles.size() + THREADS_AMOUNT - 1) / THREADS_AMOUNT;
+  vector<Diagnostics> partials(THREADS_AMOUNT);
+
+  std::vector<std::future<void>> futures;
+  for (unsigned int i = 0; i < THREADS_AMOUNT; ++i) {
+    futures.emplace_back(std::async(std::launch::async, [&, i]() {
+      Diagnostics partial;
+      size_t end = std::min((i + 1) * chunk_size, particles.size());
+      for (size_t j = i * chunk_size; j < end; j++) {
+        if (direct) {
+          apply_force(particles[j], partial);
+        } else {
+          calc_new_pos(particles[j], qt, partial);
+        }
+      }
+      partials[i] = partial;
+    }));
+  }
+
+  diagnostics = Diagnostics();
+  for (unsigned int i = 0; i < THREADS_AMOUNT; ++i) {
+    futures[i].get();
+    diagnostics.merge(partials[i]);
+  }
+}
+
+int main(int argc, char *argv[]) {
+  // `--scene <path>` loads initial conditions (see scene.hpp) instead of the
+  // scene below, the remaining arguments are the transport's.
+  string scene_path;
+  vector<char *> args;
+  for (int i = 0; i < argc; i++) {
+    if (string(argv[i]) == "--scene") {
+      if (i + 1 == argc) {
+        std::cout << "[ERROR] --scene needs a path.\n";
+        return 1;
+      }
+      scene_path = argv[++i];
+    } else {
+      args.push_back(argv[i]);
+    }
+  }
+
+  std::unique_ptr<Transport> transport =
+      create_transport((int)args.size(), args.data());
+  Domain domain(*transport);
+  if (transport->rank() != 0) {
+    domain.run_worker();
+    return 0;
+  }
+
   RenderWindow window(sf::VideoMode(sf::Vector2u(WIDTH, HEIGHT)), "GraviPar");
 
   fs::path cache_path("image-cache");
@@ -59,12 +187,27 @@ int main() {
     std::cout << "[LOG] Results folder already exists.\n";
   }
 
+  // Galaxies as {center, velocity, sun mass, radius, bodies}.
+  vector<Galaxy> scene = {
+      {Vector2f(WIDTH / 2.0, HEIGHT / 2.0), Vector2f(0.0, 0.0), 1000.0, 200.0,
+       PARTICLES_AMOUNT},
+  };
+
   vector<Particle> particles;
-  spawn_galaxy(particles, Vector2f(WIDTH / 2.0, HEIGHT / 2.0),
-               Vector2f(0.0, 0.0), 1000.0, 200.0);
+  if (scene_path.empty()) {
+    spawn_scene(particles, scene);
+  } else if (load_scene(scene_path, particles)) {
+    std::cout << "[LOG] Loaded " << particles.size() << " bodies from "
+              << scene_path << ".\n";
+  } else {
+    domain.sync(false);
+    return 1;
+  }
+  domain.local = particles;
 
   float min_vel_avg = 0.0;
   float max_vel_avg = 0.0;
+  Diagnostics diagnostics;
 
   Clock clock;
   Time elapsed;
@@ -90,87 +233,41 @@ int main() {
           recording = false;
           std::cout << "[LOG] Recording stopped.\n";
           save_video(ffmpeg_command);
+        } else if (key->scancode == sf::Keyboard::Scancode::E) {
+          string save_path =
+              "results/scene-" + std::to_string(frame_cnt) + ".bin";
+          if (save_scene(save_path, particles)) {
+            std::cout << "[LOG] Scene saved to " << save_path << ".\n";
+          }
         }
       }
     }
 
     window.clear();
 
-    update_title(clock, elapsed, window, frame_cnt_second);
+    update_title(clock, elapsed, window, frame_cnt_second, diagnostics);
 
-    Rectangle bounds(Vector2f(0.0, 0.0), WIDTH, HEIGHT);
+    Rectangle bounds = Rectangle::world();
     QuadTree qt(bounds);
 
-    // for (int i = 0; i < particles.size(); i++) {
-    //   qt.insert(particles[i]);
-    // }
-
-    // size_t chunk_size =
-    //     (particles.size() + THREADS_AMOUNT - 1) / THREADS_AMOUNT;
-    //
-    // vector<std::thread> threads;
-    //
-    // for (int i = 0; i < particles.size(); i++) {
-    //   qt.insert(particles[i]);
-    // }
-    //
-    // for (unsigned int i = 0; i < THREADS_AMOUNT; ++i) {
-    //   size_t start = i * chunk_size;
-    //   size_t end = std::min(start + chunk_size, particles.size());
-    //   if (start >= end)
-    //     break;
-    //   threads.emplace_back(insert_particles, std::ref(qt),
-    //   std::ref(particles),
-    //                        start, end);
-    // }
-    //
-    // for (auto &t : threads) {
-    //   t.join();
-    // }
-
-    std::queue<Particle> work_queue;
-    std::mutex queue_mutex;
-
-    for (auto &particle : particles) {
-      work_queue.push(particle);
+    if (transport->size() > 1) {
+      domain.sync(true);
+      domain.step(diagnostics);
+      domain.gather(particles);
+    } else {
+      step_local(particles, qt, diagnostics);
     }
 
-    std::vector<std::future<void>> futures;
-    for (unsigned int i = 0; i < THREADS_AMOUNT; ++i) {
-      futures.emplace_back(std::async(std::launch::async, [&]() {
-        while (true) {
-          Particle particle;
-          {
-            // std::lock_guard<std::mutex> lock(queue_mutex);
-            // if (work_queue.empty())
-            //   break;
-            // particle = work_queue.front();
-            // work_queue.pop();
-            {
-              std::lock_guard<std::mutex> guard(queue_mutex);
-              if (work_queue.empty())
-                break;
-              particle = std::move(work_queue.front());
-              work_queue.pop();
-            }
-          }
-          qt.insert(particle);
-        }
-      }));
-    }
-
-    for (auto &f : futures) {
-      f.get();
-    }
+    calc_avg_vel(min_vel_avg, max_vel_avg, diagnostics, frame_cnt);
 
-    for (int i = 0; i < particles.size(); i++) {
-      calc_new_pos(particles[i], qt);
+    if (transport->size() > 1 || particles.size() <= DIRECT_THRESHOLD) {
+      for (auto &particle : particles) {
+        particle.show(window, min_vel_avg, max_vel_avg);
+      }
+    } else {
+      qt.show(window, min_vel_avg, max_vel_avg);
     }
 
-    calc_avg_vel(min_vel_avg, max_vel_avg, particles, frame_cnt);
-
-    qt.show(window, min_vel_avg, max_vel_avg);
-
     if (recording) {
       save_screen(window, frame_cnt);
     }
@@ -180,5 +277,7 @@ int main() {
     frame_cnt_second++;
   }
 
+  domain.sync(false);
+
   return 0;
 }
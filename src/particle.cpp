@@ -1,50 +1,91 @@
 #include "particle.hpp"
 #include "defines.hpp"
+#include "periodic.hpp"
 #include "utils.hpp"
 #include <SFML/Graphics.hpp>
 #include <cmath>
 
-Particle::Particle() {
-  pos = sf::Vector2f(0.0, 0.0);
-  vel = sf::Vector2f(0.0, 0.0);
-  netForce = sf::Vector2f(0.0, 0.0);
+template <typename P, int D> BasicParticle<P, D>::BasicParticle() {
+  pos = vec_t();
+  vel = vec_t();
+  netForce = force_t();
+  potential = 0.0;
   mass = 0.0;
   radius = 0.0;
   index = 0;
+  work = 1;
 }
 
-Particle::Particle(sf::Vector2f _pos, sf::Vector2f _vel, float _mass,
-                   float _radius, int _index) {
+template <typename P, int D>
+BasicParticle<P, D>::BasicParticle(vec_t _pos, vec_t _vel, storage_t _mass,
+                                   storage_t _radius, int _index) {
   pos = _pos;
   vel = _vel;
-  netForce = sf::Vector2f(0.0, 0.0);
+  netForce = force_t();
+  potential = 0.0;
   mass = _mass;
   radius = _radius;
   index = _index;
+  work = 1;
 }
 
-sf::Vector2f Particle::get_attraction_force(const Particle *anotherParticle) {
-  float r = std::sqrt(std::pow(distance(pos, anotherParticle->pos), 2) +
-                      std::pow(SOFTENING, 2));
-  sf::Vector2f dir = normalize(anotherParticle->pos - pos);
-  float magnitude = G_CONST * ((mass * anotherParticle->mass) / std::pow(r, 2));
-  sf::Vector2f force = dir * magnitude;
+template <typename P, int D>
+typename BasicParticle<P, D>::force_t
+BasicParticle<P, D>::get_attraction_force(const vec_t &other_pos,
+                                          storage_t other_mass,
+                                          accum_t &potential_sum) {
+  using compute_vec_t = VectorN<D, compute_t>;
 
-  return force;
+  compute_vec_t offset(nearest_offset(other_pos));
+  compute_t dist_sq = dot(offset, offset);
+  compute_t r_sq = dist_sq + (compute_t)(SOFTENING * SOFTENING);
+  compute_t g_mass = (compute_t)G_CONST * (compute_t)(mass * other_mass);
+  compute_t magnitude = g_mass / r_sq;
+  compute_vec_t force = normalize(offset) * magnitude;
+  if constexpr (D == 2) {
+    if (PERIODIC) {
+      force += ewald_table().correction(offset.x, offset.y) * g_mass;
+    }
+  }
+
+  // Integral of the force above from r to infinity.
+  if (dist_sq > 0) {
+    compute_t softening = SOFTENING;
+    potential_sum -= g_mass / softening *
+                     atan_positive(softening / std::sqrt(dist_sq));
+  }
+
+  return force_t(force);
 }
 
-float Particle::get_distance_to(sf::Vector2f object) {
-  return hypot(object.x - pos.x, object.y - pos.y);
+template <typename P, int D>
+typename BasicParticle<P, D>::storage_t
+BasicParticle<P, D>::get_distance_to(vec_t object) {
+  return norm(nearest_offset(object));
 }
 
-sf::Color Particle::get_color(float value, sf::Color &left, sf::Color &right) {
+template <typename P, int D>
+typename BasicParticle<P, D>::vec_t
+BasicParticle<P, D>::nearest_offset(const vec_t &object) {
+  vec_t offset = object - pos;
+  if (PERIODIC) {
+    offset = wrap_offset(offset);
+  }
+  return offset;
+}
+
+template <typename P, int D>
+sf::Color BasicParticle<P, D>::get_color(float value, sf::Color &left,
+                                         sf::Color &right) {
   sf::Color color(((1.0 - value) * left.r + value * right.r),
                   ((1.0 - value) * left.g + value * right.g),
                   ((1.0 - value) * left.b + value * right.b));
   return color;
 }
 
-void Particle::show(sf::RenderWindow &window, float minVel, float maxVel) {
+template <typename P, int D>
+void BasicParticle<P, D>::show(sf::RenderWindow &window, float minVel,
+                               float maxVel) {
   float midVel = (minVel + maxVel) / 2.0;
   sf::Color left = sf::Color(42, 110, 187);
   sf::Color middle = sf::Color(122, 59, 160);
@@ -64,8 +105,15 @@ void Particle::show(sf::RenderWindow &window, float minVel, float maxVel) {
 
   // sf::RectangleShape point(sf::Vector2f(1.0, 1.0));
   sf::CircleShape point(PARTICLE_RADIUS);
-  point.setPosition(pos);
+  point.setPosition(sf::Vector2f(pos.x, pos.y));
   point.setFillColor(left);
   point.setFillColor(newColor);
   window.draw(point);
 }
+
+template class BasicParticle<FloatPrecision, 2>;
+template class BasicParticle<DoublePrecision, 2>;
+template class BasicParticle<MixedPrecision, 2>;
+template class BasicParticle<FloatPrecision, 3>;
+template class BasicParticle<DoublePrecision, 3>;
+template class BasicParticle<MixedPrecision, 3>;
@@ -0,0 +1,79 @@
+#include "periodic.hpp"
+#include <cstdlib>
+
+// Image shells summed for each grid point and shells the tail beyond them
+// is summed over before its continuum limit.
+#define EWALD_SHELLS 32
+#define EWALD_TAIL_SHELLS 1024
+
+static sf::Vector2<double> pull(double dx, double dy) {
+  double dist_sq = dx * dx + dy * dy;
+  if (dist_sq == 0.0) {
+    return sf::Vector2<double>(0.0, 0.0);
+  }
+  double magnitude = 1.0 / (std::sqrt(dist_sq) * (dist_sq + SOFTENING * SOFTENING));
+  return sf::Vector2<double>(dx * magnitude, dy * magnitude);
+}
+
+// Images beyond EWALD_SHELLS pull on an offset d by about
+// d_k * sum(1/R^3 - 3 R_k^2/R^5) along axis k, the first order of the
+// expansion in d (even orders cancel over whole shells, softening is
+// negligible that far out). Shells up to EWALD_TAIL_SHELLS are summed, the
+// rest is the continuum -2 sqrt(2) / (a W H) outside a square of half
+// side a.
+static sf::Vector2<double> tail_coefficients() {
+  sf::Vector2<double> sum(0.0, 0.0);
+  for (int shell = EWALD_SHELLS + 1; shell <= EWALD_TAIL_SHELLS; shell++) {
+    for (int n = -shell; n <= shell; n++) {
+      // The four sides of the shell, corners only once.
+      int sides[4][2] = {{n, -shell}, {n, shell}, {-shell, n}, {shell, n}};
+      for (int side = 0; side < 4; side++) {
+        if (side >= 2 && std::abs(n) == shell) {
+          continue;
+        }
+        double rx = sides[side][0] * (double)WIDTH;
+        double ry = sides[side][1] * (double)HEIGHT;
+        double dist_sq = rx * rx + ry * ry;
+        double inv_dist_cube = 1.0 / (dist_sq * std::sqrt(dist_sq));
+        sum.x += inv_dist_cube * (1.0 - 3.0 * rx * rx / dist_sq);
+        sum.y += inv_dist_cube * (1.0 - 3.0 * ry * ry / dist_sq);
+      }
+    }
+  }
+
+  double length = std::sqrt((double)WIDTH * HEIGHT);
+  double half_side = (EWALD_TAIL_SHELLS + 0.5) * length;
+  double remainder =
+      -2.0 * std::sqrt(2.0) / (half_side * (double)WIDTH * HEIGHT);
+  return sum + sf::Vector2<double>(remainder, remainder);
+}
+
+EwaldTable::EwaldTable() {
+  sf::Vector2<double> tail = tail_coefficients();
+  for (int iy = 0; iy <= EWALD_GRID; iy++) {
+    for (int ix = 0; ix <= EWALD_GRID; ix++) {
+      double dx = ix * (WIDTH / 2.0) / EWALD_GRID;
+      double dy = iy * (HEIGHT / 2.0) / EWALD_GRID;
+
+      // Whole shells keep the sum symmetric, so it converges even though
+      // a plain lattice sum of 1/r^2 in the plane does not.
+      sf::Vector2<double> sum(0.0, 0.0);
+      for (int nx = -EWALD_SHELLS; nx <= EWALD_SHELLS; nx++) {
+        for (int ny = -EWALD_SHELLS; ny <= EWALD_SHELLS; ny++) {
+          if (nx == 0 && ny == 0) {
+            continue;
+          }
+          sum += pull(dx + nx * WIDTH, dy + ny * HEIGHT);
+        }
+      }
+      sum += sf::Vector2<double>(dx * tail.x, dy * tail.y);
+      table_x[iy * (EWALD_GRID + 1) + ix] = sum.x;
+      table_y[iy * (EWALD_GRID + 1) + ix] = sum.y;
+    }
+  }
+}
+
+const EwaldTable &ewald_table() {
+  static EwaldTable table;
+  return table;
+}
@@ -2,119 +2,128 @@
 #include "defines.hpp"
 #include <thread>
 
-using std::vector, sf::Vector2f, sf::RenderWindow;
+#define MIN_CELL_SIZE 1e-3
 
-QuadTree::QuadTree(Rectangle &_bounds) : bounds(Vector2f(0.0, 0.0), 0.0, 0.0) {
-  bounds = _bounds;
-  for (int i = 0; i < 4; i++) {
+using std::vector, sf::RenderWindow;
+
+template <typename P, int D>
+BasicQuadTree<P, D>::BasicQuadTree(bounds_t &_bounds) : bounds(_bounds) {
+  for (int i = 0; i < children_amount; i++) {
     children[i] = nullptr;
   }
-  particle = nullptr;
   mass = 0.0;
-  m_center_pos = Vector2f(0.0, 0.0);
+  m_center_pos = vec_t();
 }
 
-void QuadTree::calc_force(Particle &another_particle) {
+template <typename P, int D>
+int BasicQuadTree<P, D>::calc_force(particle_t &another_particle, float theta) {
   if (!is_divided()) {
-    if (particle != nullptr) {
-      if (particle->index != another_particle.index) {
-        Vector2f attractionForce =
-            another_particle.get_attraction_force(particle.get());
-        another_particle.netForce += attractionForce;
+    int interactions = 0;
+    for (auto &particle : particles) {
+      if (particle.index != another_particle.index) {
+        another_particle.netForce += another_particle.get_attraction_force(
+            particle.pos, particle.mass, another_particle.potential);
+        interactions++;
       }
     }
-    return;
+    return interactions;
   }
 
-  float ratio = bounds.w / another_particle.get_distance_to(m_center_pos);
-  if (ratio < 0.5) {
-    Vector2f zeroVector(0.0, 0.0);
-    Particle tempParticle(m_center_pos, zeroVector, mass, 1.0, 1000000);
-    Vector2f attractionForce =
-        another_particle.get_attraction_force(&tempParticle);
-    another_particle.netForce += attractionForce;
-    return;
+  float ratio = bounds.size.x / another_particle.get_distance_to(m_center_pos);
+  if (ratio < theta) {
+    another_particle.netForce +=
+        another_particle.get_attraction_force(m_center_pos, mass,
+                                              another_particle.potential);
+    return 1;
   }
 
-  for (int i = 0; i < 4; i++) {
-    children[i]->calc_force(another_particle);
-  }
+  int interactions = 0;
+  unroll<children_amount>([&](int i) {
+    interactions += children[i]->calc_force(another_particle, theta);
+  });
+  return interactions;
 }
 
-void QuadTree::insert(Particle &new_particle) {
+template <typename P, int D>
+void BasicQuadTree<P, D>::insert(particle_t &new_particle) {
   std::lock_guard<std::recursive_mutex> lock(mtx);
   if (!bounds.contains(new_particle)) {
     return;
   }
 
-  if (particle == nullptr) {
-    particle = std::make_shared<Particle>(new_particle);
-  } else {
-    if (!is_divided()) {
-      subdivide();
+  if (!is_divided()) {
+    // Bodies this close would be split forever, the leaf keeps them all.
+    if (particles.empty() || bounds.size.x < MIN_CELL_SIZE) {
+      particles.push_back(new_particle);
+      return;
     }
 
-    for (int i = 0; i < 4; i++) {
-      children[i]->insert(new_particle);
+    subdivide();
+    for (auto &particle : particles) {
+      unroll<children_amount>([&](int i) { children[i]->insert(particle); });
     }
-
-    update_mass();
+    particles.clear();
   }
+
+  unroll<children_amount>([&](int i) { children[i]->insert(new_particle); });
 }
 
-void QuadTree::show(RenderWindow &window, float minVel, float maxVel) {
+template <typename P, int D>
+void BasicQuadTree<P, D>::show(RenderWindow &window, float minVel,
+                               float maxVel) {
   if (SHOW_BOUNDS) {
     bounds.show(window);
   }
 
   if (children[0] != nullptr) {
-    for (int i = 0; i < 4; i++) {
-      children[i]->show(window, minVel, maxVel);
-    }
+    unroll<children_amount>(
+        [&](int i) { children[i]->show(window, minVel, maxVel); });
   }
 
-  if (particle != nullptr) {
-    particle->show(window, minVel, maxVel);
+  for (auto &particle : particles) {
+    particle.show(window, minVel, maxVel);
   }
 }
 
-void QuadTree::show(RenderWindow &window, vector<int> &particles_to_draw,
-                    float min_vel, float max_vel) {
+template <typename P, int D>
+void BasicQuadTree<P, D>::show(RenderWindow &window,
+                               vector<int> &particles_to_draw, float min_vel,
+                               float max_vel) {
   if (SHOW_BOUNDS) {
     bounds.show(window);
   }
 
   if (children[0] != nullptr) {
-    for (int i = 0; i < 4; i++) {
+    unroll<children_amount>([&](int i) {
       children[i]->show(window, particles_to_draw, min_vel, max_vel);
-    }
+    });
   }
 
-  if (particle != nullptr) {
-    int targetIndex = particle->index;
+  for (auto &particle : particles) {
+    int targetIndex = particle.index;
     auto findParticle = std::find_if(
         particles_to_draw.begin(), particles_to_draw.end(),
         [&targetIndex](const auto &index) { return index == targetIndex; });
 
     if (findParticle != particles_to_draw.end()) {
-      particle->show(window, min_vel, max_vel);
+      particle.show(window, min_vel, max_vel);
     }
   }
 }
 
-vector<int> QuadTree::query(Rectangle &rect) {
+template <typename P, int D> vector<int> BasicQuadTree<P, D>::query(bounds_t &rect) {
   vector<int> results;
   if (!bounds.intersects(rect)) {
     return results;
   }
 
-  if (particle != nullptr) {
-    if (rect.contains(*particle)) {
-      results.push_back(particle->index);
+  for (auto &particle : particles) {
+    if (rect.contains(particle)) {
+      results.push_back(particle.index);
     }
   }
   if (is_divided()) {
-    for (int i = 0; i < 4; i++) {
+    for (int i = 0; i < children_amount; i++) {
       vector<int> leafResults = children[i]->query(rect);
       results.insert(results.end(), leafResults.begin(), leafResults.end());
     }
@@ -123,45 +132,59 @@ vector<int> QuadTree::query(Rectangle &rect) {
   return results;
 }
 
-bool QuadTree::is_divided() { return children[0] != nullptr; }
-
-void QuadTree::subdivide() {
-  float x = bounds.top_left_pos.x;
-  float y = bounds.top_left_pos.y;
-  float w = bounds.w;
-  float h = bounds.h;
-  Rectangle topleft(Vector2f(x, y), w / 2.0, h / 2.0);
-  Rectangle topright(Vector2f(x + w / 2.0, y), w / 2.0, h / 2.0);
-  Rectangle bottomleft(Vector2f(x, y + h / 2.0), w / 2.0, h / 2.0);
-  Rectangle bottomright(Vector2f(x + w / 2.0, y + h / 2.0), w / 2.0, h / 2.0);
-
-  children[0] = std::make_shared<QuadTree>(topleft);
-  children[1] = std::make_shared<QuadTree>(topright);
-  children[2] = std::make_shared<QuadTree>(bottomleft);
-  children[3] = std::make_shared<QuadTree>(bottomright);
+template <typename P, int D> bool BasicQuadTree<P, D>::is_divided() {
+  return children[0] != nullptr;
+}
+
+template <typename P, int D> void BasicQuadTree<P, D>::subdivide() {
+  using corner_t = typename bounds_t::vec_t;
+
+  corner_t half = bounds.size / 2.0f;
+  // Bit k of a child's index selects the upper half along axis k, so in two
+  // dimensions the children are top left, top right, bottom left and bottom
+  // right.
+  unroll<children_amount>([&](int i) {
+    corner_t corner = bounds.top_left_pos;
+    unroll<D>([&](int k) {
+      if (i & (1 << k)) {
+        axis(corner, k) += axis(half, k);
+      }
+    });
+    bounds_t child_bounds(corner, half);
+    children[i] = std::make_shared<BasicQuadTree>(child_bounds);
+  });
 }
 
-void QuadTree::update_mass() {
+template <typename P, int D> void BasicQuadTree<P, D>::update_mass() {
+  accum_t mass_sum = 0.0;
+  VectorN<D, accum_t> center;
+
   if (!is_divided()) {
-    if (particle == nullptr) {
+    if (particles.empty()) {
       return;
     }
-    mass = particle->mass;
-    m_center_pos = particle->pos;
+    for (auto &particle : particles) {
+      mass_sum += particle.mass;
+      center += VectorN<D, accum_t>(particle.pos) * (accum_t)particle.mass;
+    }
+    mass = mass_sum;
+    m_center_pos = vec_t(center / mass_sum);
     return;
   }
-  float mass_sum = 0.0;
-  float center_x = 0.0;
-  float center_y = 0.0;
 
-  for (int i = 0; i < 4; i++) {
+  unroll<children_amount>([&](int i) {
     children[i]->update_mass();
     mass_sum += children[i]->mass;
-    center_x += children[i]->m_center_pos.x * children[i]->mass;
-    center_y += children[i]->m_center_pos.y * children[i]->mass;
-  }
+    center += VectorN<D, accum_t>(children[i]->m_center_pos) *
+              (accum_t)children[i]->mass;
+  });
   mass = mass_sum;
-  center_x /= mass_sum;
-  center_y /= mass_sum;
-  m_center_pos = Vector2f(center_x, center_y);
+  m_center_pos = vec_t(center / mass_sum);
 }
+
+template class BasicQuadTree<FloatPrecision, 2>;
+template class BasicQuadTree<DoublePrecision, 2>;
+template class BasicQuadTree<MixedPrecision, 2>;
+template class BasicQuadTree<FloatPrecision, 3>;
+template class BasicQuadTree<DoublePrecision, 3>;
+template class BasicQuadTree<MixedPrecision, 3>;
@@ -1,30 +1,38 @@
 #include "rectangle.hpp"
 #include <SFML/Graphics.hpp>
 
-Rectangle::Rectangle(sf::Vector2f _top_left_pos, float _w, float _h) {
+template <int D>
+BasicRectangle<D>::BasicRectangle(vec_t _top_left_pos, vec_t _size) {
   top_left_pos = _top_left_pos;
-  w = _w;
-  h = _h;
+  size = _size;
 }
 
-bool Rectangle::contains(Particle &particle) {
-  return top_left_pos.x <= particle.pos.x && top_left_pos.y <= particle.pos.y &&
-         top_left_pos.x + w > particle.pos.x && top_left_pos.y + h > particle.pos.y;
+template <int D> BasicRectangle<D> BasicRectangle<D>::world() {
+  vec_t size;
+  unroll<D>([&](int k) { axis(size, k) = world_extent(k); });
+  return BasicRectangle(vec_t(), size);
 }
 
-bool Rectangle::intersects(Rectangle &rect) {
-  bool up = rect.top_left_pos.y + rect.h < top_left_pos.y;
-  bool down = rect.top_left_pos.y > top_left_pos.y + h;
-  bool left = rect.top_left_pos.x + rect.w < top_left_pos.x;
-  bool right = rect.top_left_pos.x > top_left_pos.x + w;
-  return !(up || down || left || right);
+template <int D> bool BasicRectangle<D>::intersects(BasicRectangle &rect) {
+  bool apart = false;
+  unroll<D>([&](int k) {
+    bool before = axis(rect.top_left_pos, k) + axis(rect.size, k) <
+                  axis(top_left_pos, k);
+    bool after =
+        axis(rect.top_left_pos, k) > axis(top_left_pos, k) + axis(size, k);
+    apart = apart || before || after;
+  });
+  return !apart;
 }
 
-void Rectangle::show(sf::RenderWindow &window) {
-  sf::RectangleShape rect(sf::Vector2f(w, h));
-  rect.setPosition(top_left_pos);
+template <int D> void BasicRectangle<D>::show(sf::RenderWindow &window) {
+  sf::RectangleShape rect(sf::Vector2f(size.x, size.y));
+  rect.setPosition(sf::Vector2f(top_left_pos.x, top_left_pos.y));
   rect.setOutlineColor(sf::Color::White);
   rect.setFillColor(sf::Color::Transparent);
   rect.setOutlineThickness(1);
   window.draw(rect);
 }
+
+template class BasicRectangle<2>;
+template class BasicRectangle<3>;
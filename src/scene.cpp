@@ -0,0 +1,424 @@
+#include "scene.hpp"
+#include "defines.hpp"
+#include "spawns.hpp"
+#include <atomic>
+#include <cctype>
+#include <charconv>
+#include <climits>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string_view>
+
+namespace fs = std::filesystem;
+
+using std::string_view;
+
+// Bytes every thread reads or writes at once.
+#define SCENE_BLOCK (1 << 20)
+#define SCENE_MAGIC "GPSC"
+
+// Values of a record: position, velocity, mass and (optional in CSV) radius.
+#define RECORD_MIN (2 * DIMENSIONS + 1)
+#define RECORD_MAX (2 * DIMENSIONS + 2)
+// Values of a galaxy: center, velocity, sun mass, radius and body count.
+#define GALAXY_VALUES 7
+
+struct SceneHeader {
+  char magic[4];
+  uint32_t dimensions;
+  uint64_t count;
+};
+
+static Particle make_particle(const double *values, bool has_radius,
+                              int index) {
+  Particle::vec_t pos, vel;
+  unroll<DIMENSIONS>([&](int k) {
+    axis(pos, k) = values[k];
+    axis(vel, k) = values[DIMENSIONS + k];
+  });
+  double radius = has_radius ? values[RECORD_MAX - 1] : PARTICLE_RADIUS;
+  return Particle(pos, vel, values[2 * DIMENSIONS], radius, index);
+}
+
+static void record_values(const Particle &particle, double *values) {
+  unroll<DIMENSIONS>([&](int k) {
+    values[k] = axis(particle.pos, k);
+    values[DIMENSIONS + k] = axis(particle.vel, k);
+  });
+  values[2 * DIMENSIONS] = particle.mass;
+  values[RECORD_MAX - 1] = particle.radius;
+}
+
+static bool is_blank(string_view line) {
+  return line.find_first_not_of(" \t\r") == string_view::npos;
+}
+
+// Comma separated numbers of a line, false if there are more than
+// max_count of them or anything else.
+static bool parse_values(string_view line, double *values, int max_count,
+                         int &count) {
+  const char *pos = line.data();
+  const char *end = pos + line.size();
+  count = 0;
+
+  while (true) {
+    while (pos < end && (*pos == ' ' || *pos == '\t')) {
+      pos++;
+    }
+    if (count == max_count) {
+      return false;
+    }
+    std::from_chars_result result = std::from_chars(pos, end, values[count]);
+    if (result.ec != std::errc()) {
+      return false;
+    }
+    count++;
+
+    pos = result.ptr;
+    while (pos < end && (*pos == ' ' || *pos == '\t' || *pos == '\r')) {
+      pos++;
+    }
+    if (pos == end) {
+      break;
+    }
+    if (*pos != ',') {
+      return false;
+    }
+    pos++;
+  }
+
+  return true;
+}
+
+// Numbers of a CSV line, false unless there are RECORD_MIN or RECORD_MAX of
+// them.
+static bool parse_record(string_view line, double *values, int &count) {
+  return parse_values(line, values, RECORD_MAX, count) && count >= RECORD_MIN;
+}
+
+// Calls f(line) for every line of the bytes [begin, end) of a file, which
+// start at the beginning of a line, reading SCENE_BLOCK bytes at a time.
+// Stops when f returns false.
+template <typename F>
+static bool for_each_line(const string &path, size_t begin, size_t end, F f) {
+  std::ifstream file(path, std::ios::binary);
+  file.seekg(begin);
+
+  vector<char> buffer(SCENE_BLOCK);
+  string carry;
+  for (size_t pos = begin; pos < end;) {
+    size_t amount = std::min<size_t>(SCENE_BLOCK, end - pos);
+    if (!file.read(buffer.data(), amount)) {
+      return false;
+    }
+    pos += amount;
+
+    const char *start = buffer.data();
+    const char *stop = start + amount;
+    while (const char *newline =
+               (const char *)std::memchr(start, '\n', stop - start)) {
+      bool keep_going;
+      if (carry.empty()) {
+        keep_going = f(string_view(start, newline - start));
+      } else {
+        carry.append(start, newline);
+        keep_going = f(string_view(carry));
+        carry.clear();
+      }
+      if (!keep_going) {
+        return true;
+      }
+      start = newline + 1;
+    }
+    carry.append(start, stop);
+  }
+
+  if (!carry.empty()) {
+    f(string_view(carry));
+  }
+  return true;
+}
+
+static bool load_csv(const string &path, vector<Particle> &particles,
+                     int threads) {
+  std::ifstream file(path, std::ios::binary);
+  if (!file) {
+    std::cout << "[ERROR] Failed to open " << path << ".\n";
+    return false;
+  }
+  size_t size = fs::file_size(path);
+
+  // A first line starting with a letter is the header.
+  string line;
+  std::getline(file, line);
+  size_t data_start = 0;
+  size_t first_char = line.find_first_not_of(" \t");
+  if (first_char != string::npos &&
+      std::isalpha((unsigned char)line[first_char])) {
+    data_start = std::min(size, line.size() + 1);
+  }
+
+  // Chunks of about equal size, each moved on to the start of a line.
+  threads = std::max(1, threads);
+  vector<size_t> starts(threads + 1, size);
+  starts[0] = data_start;
+  for (int t = 1; t < threads; t++) {
+    file.clear();
+    file.seekg(data_start + (size - data_start) * t / threads);
+    std::getline(file, line);
+    starts[t] = file && !file.eof() ? (size_t)file.tellg() : size;
+    starts[t] = std::max(starts[t], starts[t - 1]);
+  }
+
+  // Records per chunk first, so every chunk knows where its bodies go.
+  vector<size_t> counts(threads, 0);
+  std::atomic<bool> failed = false;
+  parallel_chunks(threads, threads, [&](size_t chunk, size_t end_chunk) {
+    for (size_t t = chunk; t < end_chunk; t++) {
+      auto count_line = [&](string_view line) {
+        counts[t] += !is_blank(line);
+        return true;
+      };
+      if (!for_each_line(path, starts[t], starts[t + 1], count_line)) {
+        failed = true;
+      }
+    }
+  });
+  if (failed) {
+    std::cout << "[ERROR] Failed to read " << path << ".\n";
+    return false;
+  }
+
+  size_t first = particles.size();
+  vector<size_t> offsets(threads + 1, first);
+  for (int t = 0; t < threads; t++) {
+    offsets[t + 1] = offsets[t] + counts[t];
+  }
+  particles.resize(offsets[threads]);
+
+  parallel_chunks(threads, threads, [&](size_t chunk, size_t end_chunk) {
+    for (size_t t = chunk; t < end_chunk; t++) {
+      size_t i = offsets[t];
+      auto parse_line = [&](string_view line) {
+        if (is_blank(line)) {
+          return true;
+        }
+        double values[RECORD_MAX];
+        int count;
+        if (!parse_record(line, values, count)) {
+          std::cout << "[ERROR] " + path + ": record " +
+                           std::to_string(i - first + 1) + " is malformed.\n";
+          failed = true;
+        } else {
+          particles[i] = make_particle(values, count == RECORD_MAX, i);
+          i++;
+        }
+        return !failed;
+      };
+      if (!for_each_line(path, starts[t], starts[t + 1], parse_line)) {
+        std::cout << "[ERROR] Failed to read " + path + ".\n";
+        failed = true;
+      }
+    }
+  });
+
+  if (failed) {
+    particles.resize(first);
+    return false;
+  }
+  return true;
+}
+
+static bool load_binary(const string &path, vector<Particle> &particles,
+                        int threads) {
+  std::ifstream file(path, std::ios::binary);
+  if (!file) {
+    std::cout << "[ERROR] Failed to open " << path << ".\n";
+    return false;
+  }
+
+  SceneHeader header;
+  if (!file.read((char *)&header, sizeof(header)) ||
+      std::memcmp(header.magic, SCENE_MAGIC, sizeof(header.magic)) != 0) {
+    std::cout << "[ERROR] " << path << " is not a scene file.\n";
+    return false;
+  }
+  if (header.dimensions != DIMENSIONS) {
+    std::cout << "[ERROR] " << path << " has " << header.dimensions
+              << " dimensions, the simulation " << DIMENSIONS << ".\n";
+    return false;
+  }
+  size_t n = header.count;
+  size_t expected_size = sizeof(header) + n * RECORD_MAX * sizeof(double);
+  if (fs::file_size(path) != expected_size) {
+    std::cout << "[ERROR] " << path << " does not hold " << n << " bodies.\n";
+    return false;
+  }
+
+  size_t first = particles.size();
+  particles.resize(first + n);
+
+  // Every thread streams its range of each array a block of bodies at a
+  // time and assembles the bodies from the columns.
+  std::atomic<bool> failed = false;
+  parallel_chunks(n, threads, [&](size_t begin, size_t end) {
+    std::ifstream chunk_file(path, std::ios::binary);
+    size_t block = SCENE_BLOCK / (RECORD_MAX * sizeof(double));
+    vector<double> columns(block * RECORD_MAX);
+    double values[RECORD_MAX];
+
+    for (size_t start = begin; start < end && !failed; start += block) {
+      size_t amount = std::min(block, end - start);
+      for (int a = 0; a < RECORD_MAX; a++) {
+        chunk_file.seekg(sizeof(header) + (a * n + start) * sizeof(double));
+        chunk_file.read((char *)&columns[a * block], amount * sizeof(double));
+      }
+      if (!chunk_file) {
+        failed = true;
+        break;
+      }
+
+      for (size_t j = 0; j < amount; j++) {
+        for (int a = 0; a < RECORD_MAX; a++) {
+          values[a] = columns[a * block + j];
+        }
+        particles[first + start + j] =
+            make_particle(values, true, first + start + j);
+      }
+    }
+  });
+
+  if (failed) {
+    std::cout << "[ERROR] Failed to read " << path << ".\n";
+    particles.resize(first);
+    return false;
+  }
+  return true;
+}
+
+static bool save_csv(const string &path, const vector<Particle> &particles) {
+  std::ofstream file(path, std::ios::binary);
+
+  const char *axis_names = "xyz";
+  string buffer;
+  for (int k = 0; k < DIMENSIONS; k++) {
+    buffer += string(1, axis_names[k]) + ",";
+  }
+  for (int k = 0; k < DIMENSIONS; k++) {
+    buffer += "v" + string(1, axis_names[k]) + ",";
+  }
+  buffer += "mass,radius\n";
+
+  char number[32];
+  double values[RECORD_MAX];
+  for (auto &particle : particles) {
+    record_values(particle, values);
+    for (int a = 0; a < RECORD_MAX; a++) {
+      std::to_chars_result result =
+          std::to_chars(number, number + sizeof(number), values[a]);
+      buffer.append(number, result.ptr);
+      buffer += a + 1 < RECORD_MAX ? ',' : '\n';
+    }
+
+    if (buffer.size() >= SCENE_BLOCK) {
+      file.write(buffer.data(), buffer.size());
+      buffer.clear();
+    }
+  }
+  file.write(buffer.data(), buffer.size());
+
+  return (bool)file;
+}
+
+static bool save_binary(const string &path, const vector<Particle> &particles) {
+  std::ofstream file(path, std::ios::binary);
+
+  SceneHeader header;
+  std::memcpy(header.magic, SCENE_MAGIC, sizeof(header.magic));
+  header.dimensions = DIMENSIONS;
+  header.count = particles.size();
+  file.write((const char *)&header, sizeof(header));
+
+  size_t block = SCENE_BLOCK / sizeof(double);
+  vector<double> column(block);
+  double values[RECORD_MAX];
+  for (int a = 0; a < RECORD_MAX; a++) {
+    for (size_t start = 0; start < particles.size(); start += block) {
+      size_t amount = std::min(block, particles.size() - start);
+      for (size_t j = 0; j < amount; j++) {
+        record_values(particles[start + j], values);
+        column[j] = values[a];
+      }
+      file.write((const char *)column.data(), amount * sizeof(double));
+    }
+  }
+
+  return (bool)file;
+}
+
+static bool load_galaxies(const string &path, vector<Particle> &particles) {
+  std::ifstream file(path);
+  if (!file) {
+    std::cout << "[ERROR] Failed to open " << path << ".\n";
+    return false;
+  }
+
+  vector<Galaxy> galaxies;
+  string line;
+  while (std::getline(file, line)) {
+    string_view values_part = string_view(line).substr(0, line.find('#'));
+    if (is_blank(values_part)) {
+      continue;
+    }
+
+    double values[GALAXY_VALUES];
+    int count;
+    // Range first, converting an out of range body count to int is undefined.
+    if (!parse_values(values_part, values, GALAXY_VALUES, count) ||
+        count != GALAXY_VALUES || !(values[6] >= 0 && values[6] <= INT_MAX) ||
+        values[6] != std::floor(values[6])) {
+      std::cout << "[ERROR] " << path << ": galaxy " << galaxies.size() + 1
+                << " is malformed.\n";
+      return false;
+    }
+    int bodies = (int)values[6];
+    galaxies.push_back({Vector2f(values[0], values[1]),
+                        Vector2f(values[2], values[3]), (float)values[4],
+                        (float)values[5], bodies});
+  }
+
+  spawn_scene(particles, galaxies);
+  return true;
+}
+
+static bool has_extension(const string &path, const char *extension) {
+  return fs::path(path).extension() == extension;
+}
+
+bool load_scene(const string &path, vector<Particle> &particles,
+                int threads) {
+  if (has_extension(path, ".galaxies")) {
+    return load_galaxies(path, particles);
+  }
+  if (has_extension(path, ".csv")) {
+    return load_csv(path, particles, threads);
+  }
+  return load_binary(path, particles, threads);
+}
+
+bool save_scene(const string &path, const vector<Particle> &particles) {
+  if (has_extension(path, ".galaxies")) {
+    std::cout << "[ERROR] " << path << ": galaxy lists can't be saved.\n";
+    return false;
+  }
+  bool saved = has_extension(path, ".csv") ? save_csv(path, particles)
+                                            : save_binary(path, particles);
+  if (!saved) {
+    std::cout << "[ERROR] Failed to write " << path << ".\n";
+  }
+  return saved;
+}
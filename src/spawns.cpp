@@ -2,52 +2,87 @@
 #include "defines.hpp"
 #include "utils.hpp"
 #include <cmath>
+#include <random>
 
-void spawn_circle(vector<Particle> &particles, Vector2f center) {
-  for (int i = 0; i < PARTICLES_AMOUNT; i++) {
-    Vector2f pos = random_in_circle(PARTICLE_RADIUS, 0.0, center);
-    Particle newParticle(pos, Vector2f(0.0, 0.0), PARTICLE_MASS, 0.00001, i);
-    particles.push_back(newParticle);
-  }
+// Appends count bodies made by make(gen, index). Storage grows once and
+// chunks are filled in parallel, each thread with its own generator.
+template <typename F>
+static void spawn_parallel(vector<Particle> &particles, int count, F make) {
+  size_t first = particles.size();
+  particles.resize(first + count);
+
+  parallel_chunks(count, loader_threads(), [&](size_t begin, size_t end) {
+    std::random_device rd;
+    std::mt19937 gen(rd());
+    for (size_t i = first + begin; i < first + end; i++) {
+      particles[i] = make(gen, i);
+    }
+  });
+}
+
+void spawn_circle(vector<Particle> &particles, Vector2f center, int count) {
+  spawn_parallel(particles, count, [&](std::mt19937 &gen, int index) {
+    Vector2f pos = random_in_circle(PARTICLE_RADIUS, 0.0, center, gen);
+    return Particle(lift<Particle::vec_t>(pos, DEPTH / 2.0), Particle::vec_t(),
+                    PARTICLE_MASS, 0.00001, index);
+  });
 }
 
-void spawn_spinning_circle(vector<Particle> &particles, Vector2f center) {
-  for (int i = 0; i < PARTICLES_AMOUNT; i++) {
-    Vector2f pos = random_in_circle(PARTICLE_RADIUS, 1.0, center);
+void spawn_spinning_circle(vector<Particle> &particles, Vector2f center,
+                           int count) {
+  spawn_parallel(particles, count, [&](std::mt19937 &gen, int index) {
+    Vector2f pos = random_in_circle(PARTICLE_RADIUS, 1.0, center, gen);
 
     float distance_to_center = distance(pos, center);
     float orbital_vel = sqrt((G_CONST * 900.0) / distance_to_center);
 
     Vector2f dir = normalize(Vector2f(pos.y - center.y, center.x - pos.x));
-    Particle new_particle(pos, dir * orbital_vel, PARTICLE_MASS, 0.00001, i);
-
-    particles.push_back(new_particle);
-  }
+    return Particle(lift<Particle::vec_t>(pos, DEPTH / 2.0),
+                    lift<Particle::vec_t>(dir * orbital_vel), PARTICLE_MASS,
+                    0.00001, index);
+  });
 }
 
 void spawn_galaxy(vector<Particle> &particles, Vector2f center,
-                  Vector2f initial_vel, float sun_mass, float radius) {
-  for (int i = 0; i < PARTICLES_AMOUNT; i++) {
-    Vector2f pos = random_in_circle(radius, 5.0, center);
+                  Vector2f initial_vel, float sun_mass, float radius,
+                  int count) {
+  spawn_parallel(particles, count, [&](std::mt19937 &gen, int index) {
+    Vector2f pos = random_in_circle(radius, 5.0, center, gen);
 
     float distance_to_center = distance(pos, center);
     float orbital_vel = sqrt((G_CONST * sun_mass) / distance_to_center);
 
+    // Stars move with their galaxy on top of the orbit around its sun.
     Vector2f dir = normalize(Vector2f(pos.y - center.y, center.x - pos.x));
-    Particle new_particle(pos, dir * orbital_vel, PARTICLE_MASS, 0.00001, i);
-
-    particles.push_back(new_particle);
-  }
-  Particle sun(center, initial_vel, sun_mass, PARTICLE_RADIUS + 0.5,
-               PARTICLES_AMOUNT);
+    return Particle(lift<Particle::vec_t>(pos, DEPTH / 2.0),
+                    lift<Particle::vec_t>(dir * orbital_vel + initial_vel),
+                    PARTICLE_MASS, 0.00001, index);
+  });
+  Particle sun(lift<Particle::vec_t>(center, DEPTH / 2.0),
+               lift<Particle::vec_t>(initial_vel), sun_mass,
+               PARTICLE_RADIUS + 0.5, particles.size());
   particles.push_back(sun);
 }
 
-void spawn_screen(vector<Particle> &particles) {
-  for (int i = 0; i < PARTICLES_AMOUNT; i++) {
-    Vector2f pos = random_on_screen();
-    Vector2f speed = random_speed();
-    Particle new_particle(pos, speed, PARTICLE_MASS, 0.00001, i);
-    particles.push_back(new_particle);
+void spawn_screen(vector<Particle> &particles, int count) {
+  spawn_parallel(particles, count, [&](std::mt19937 &gen, int index) {
+    Vector2f pos = random_on_screen(gen);
+    Vector2f speed = random_speed(gen);
+    return Particle(lift<Particle::vec_t>(pos, random_depth(gen)),
+                    lift<Particle::vec_t>(speed), PARTICLE_MASS, 0.00001,
+                    index);
+  });
+}
+
+void spawn_scene(vector<Particle> &particles, const vector<Galaxy> &galaxies) {
+  size_t total = particles.size();
+  for (auto &galaxy : galaxies) {
+    total += galaxy.count + 1;
+  }
+  particles.reserve(total);
+
+  for (auto &galaxy : galaxies) {
+    spawn_galaxy(particles, galaxy.center, galaxy.velocity, galaxy.sun_mass,
+                 galaxy.radius, galaxy.count);
   }
 }
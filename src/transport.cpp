@@ -0,0 +1,225 @@
+#include "transport.hpp"
+#include "defines.hpp"
+#include <arpa/inet.h>
+#include <charconv>
+#include <cstdint>
+#include <iostream>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <thread>
+#include <unistd.h>
+
+using std::to_string;
+
+static void fail(const string &message) {
+  std::cout << "[ERROR] " << message << std::endl;
+  std::exit(1);
+}
+
+static void write_all(int fd, const void *buffer, size_t size) {
+  const char *data = static_cast<const char *>(buffer);
+  while (size > 0) {
+    ssize_t written = ::send(fd, data, size, MSG_NOSIGNAL);
+    if (written <= 0) {
+      fail("Lost connection to a peer process.");
+    }
+    data += written;
+    size -= written;
+  }
+}
+
+static void read_all(int fd, void *buffer, size_t size) {
+  char *data = static_cast<char *>(buffer);
+  while (size > 0) {
+    ssize_t received = ::recv(fd, data, size, 0);
+    if (received <= 0) {
+      fail("Lost connection to a peer process.");
+    }
+    data += received;
+    size -= received;
+  }
+}
+
+static addrinfo *resolve(const string &host, bool passive) {
+  size_t colon = host.rfind(':');
+  if (colon == string::npos) {
+    fail("Host \"" + host + "\" has no port.");
+  }
+  string address = host.substr(0, colon);
+  string port = host.substr(colon + 1);
+
+  addrinfo hints = {};
+  hints.ai_family = AF_INET;
+  hints.ai_socktype = SOCK_STREAM;
+  hints.ai_flags = passive ? AI_PASSIVE : 0;
+
+  addrinfo *result = nullptr;
+  if (getaddrinfo(passive ? nullptr : address.c_str(), port.c_str(), &hints,
+                  &result) != 0) {
+    fail("Could not resolve \"" + host + "\".");
+  }
+  return result;
+}
+
+static void set_nodelay(int fd) {
+  int flag = 1;
+  setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &flag, sizeof(flag));
+}
+
+vector<vector<char>> Transport::exchange(vector<vector<char>> &outgoing) {
+  int n = size();
+  int r = rank();
+  vector<vector<char>> incoming(n);
+  incoming[r] = std::move(outgoing[r]);
+
+  // Every rank sends to r + k while receiving from r - k, so each blocking
+  // read is matched by a peer that is already writing to it.
+  std::thread sender([&]() {
+    for (int k = 1; k < n; k++) {
+      send((r + k) % n, outgoing[(r + k) % n]);
+    }
+  });
+  for (int k = 1; k < n; k++) {
+    int from = (r - k + n) % n;
+    incoming[from] = recv(from);
+  }
+  sender.join();
+
+  return incoming;
+}
+
+int LocalTransport::rank() { return 0; }
+
+int LocalTransport::size() { return 1; }
+
+void LocalTransport::send(int, const vector<char> &) {
+  fail("LocalTransport has no peers to send to.");
+}
+
+vector<char> LocalTransport::recv(int) {
+  fail("LocalTransport has no peers to receive from.");
+  return {};
+}
+
+SocketTransport::SocketTransport(int _rank, vector<string> &hosts)
+    : my_rank(_rank), listen_fd(-1), peers(hosts.size(), -1) {
+  addrinfo *local = resolve(hosts[my_rank], true);
+  listen_fd = socket(local->ai_family, local->ai_socktype, 0);
+  int reuse = 1;
+  setsockopt(listen_fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+  if (bind(listen_fd, local->ai_addr, local->ai_addrlen) != 0 ||
+      listen(listen_fd, hosts.size()) != 0) {
+    fail("Rank " + to_string(my_rank) + " could not listen on " +
+         hosts[my_rank] + ".");
+  }
+  freeaddrinfo(local);
+
+  // Lower ranks are dialed, higher ranks dial us and introduce themselves.
+  for (int peer = 0; peer < my_rank; peer++) {
+    addrinfo *remote = resolve(hosts[peer], false);
+    int fd = -1;
+    for (int attempt = 0; attempt < 200; attempt++) {
+      fd = socket(remote->ai_family, remote->ai_socktype, 0);
+      if (connect(fd, remote->ai_addr, remote->ai_addrlen) == 0) {
+        break;
+      }
+      close(fd);
+      fd = -1;
+      usleep(50000);
+    }
+    freeaddrinfo(remote);
+    if (fd < 0) {
+      fail("Rank " + to_string(my_rank) + " could not reach " + hosts[peer] +
+           ".");
+    }
+    int32_t id = my_rank;
+    write_all(fd, &id, sizeof(id));
+    set_nodelay(fd);
+    peers[peer] = fd;
+  }
+
+  for (int i = my_rank + 1; i < (int)hosts.size(); i++) {
+    int fd = accept(listen_fd, nullptr, nullptr);
+    if (fd < 0) {
+      fail("Rank " + to_string(my_rank) + " failed to accept a peer.");
+    }
+    int32_t id;
+    read_all(fd, &id, sizeof(id));
+    set_nodelay(fd);
+    peers[id] = fd;
+  }
+}
+
+SocketTransport::~SocketTransport() {
+  for (int fd : peers) {
+    if (fd >= 0) {
+      close(fd);
+    }
+  }
+  if (listen_fd >= 0) {
+    close(listen_fd);
+  }
+  for (pid_t child : children) {
+    waitpid(child, nullptr, 0);
+  }
+}
+
+int SocketTransport::rank() { return my_rank; }
+
+int SocketTransport::size() { return peers.size(); }
+
+void SocketTransport::send(int to, const vector<char> &data) {
+  uint64_t length = data.size();
+  write_all(peers[to], &length, sizeof(length));
+  write_all(peers[to], data.data(), data.size());
+}
+
+vector<char> SocketTransport::recv(int from) {
+  uint64_t length;
+  read_all(peers[from], &length, sizeof(length));
+  vector<char> data(length);
+  read_all(peers[from], data.data(), length);
+  return data;
+}
+
+std::unique_ptr<Transport> create_transport(int argc, char *argv[]) {
+  if (argc >= 3) {
+    vector<string> hosts(argv + 2, argv + argc);
+    string rank_arg = argv[1];
+    int rank = -1;
+    std::from_chars_result result = std::from_chars(
+        rank_arg.data(), rank_arg.data() + rank_arg.size(), rank);
+    if (result.ec != std::errc() ||
+        result.ptr != rank_arg.data() + rank_arg.size() || rank < 0 ||
+        rank >= (int)hosts.size()) {
+      fail("Rank \"" + rank_arg + "\" is not between 0 and " +
+           to_string(hosts.size() - 1) + ".");
+    }
+    return std::make_unique<SocketTransport>(rank, hosts);
+  }
+
+  if (PROCESSES_AMOUNT <= 1) {
+    return std::make_unique<LocalTransport>();
+  }
+
+  vector<string> hosts;
+  for (int i = 0; i < PROCESSES_AMOUNT; i++) {
+    hosts.push_back("127.0.0.1:" + to_string(BASE_PORT + i));
+  }
+
+  vector<pid_t> children;
+  for (int i = 1; i < PROCESSES_AMOUNT; i++) {
+    pid_t pid = fork();
+    if (pid == 0) {
+      return std::make_unique<SocketTransport>(i, hosts);
+    }
+    children.push_back(pid);
+  }
+
+  auto transport = std::make_unique<SocketTransport>(0, hosts);
+  transport->children = children;
+  return transport;
+}
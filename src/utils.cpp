@@ -6,51 +6,35 @@
 #include <cmath>
 #include <cstdint>
 #include <random>
+#include <thread>
 #include <vector>
 
 using std::vector, std::fmod;
 
-float distance(const sf::Vector2f &point1, const sf::Vector2f &point2) {
-  float dx = point1.x - point2.x;
-  float dy = point1.y - point2.y;
-  return std::sqrt(dx * dx + dy * dy);
-}
-
-float norm(const sf::Vector2f &vector) {
-  return std::sqrt(vector.x * vector.x + vector.y * vector.y);
-}
-
-sf::Vector2f normalize(const sf::Vector2f &vector) {
-  float length = std::sqrt(vector.x * vector.x + vector.y * vector.y);
-
-  if (length != 0) {
-    return sf::Vector2f(vector.x / length, vector.y / length);
-  } else {
-    return vector;
+int loader_threads() {
+  if (LOADER_THREADS > 0) {
+    return LOADER_THREADS;
   }
+  return std::max(1u, std::thread::hardware_concurrency());
 }
 
-sf::Vector2f random_in_circle(float radius, float padding,
-                              sf::Vector2f center) {
-  std::random_device rd;
-  float angle = std::generate_canonical<float, 10>(rd) * 2.0 * M_PI;
+sf::Vector2f random_in_circle(float radius, float padding, sf::Vector2f center,
+                              std::mt19937 &gen) {
+  float angle = std::generate_canonical<float, 10>(gen) * 2.0 * M_PI;
   float distance =
-      padding + std::generate_canonical<float, 10>(rd) * (radius - padding);
+      padding + std::generate_canonical<float, 10>(gen) * (radius - padding);
 
   return sf::Vector2f(distance * std::cos(angle), distance * std::sin(angle)) +
          center;
 }
 
-sf::Vector2f random_on_screen() {
-  std::random_device rd;
-  float x = std::generate_canonical<float, 10>(rd) * WIDTH;
-  float y = std::generate_canonical<float, 10>(rd) * HEIGHT;
+sf::Vector2f random_on_screen(std::mt19937 &gen) {
+  float x = std::generate_canonical<float, 10>(gen) * WIDTH;
+  float y = std::generate_canonical<float, 10>(gen) * HEIGHT;
   return sf::Vector2f(x, y);
 }
 
-sf::Vector2f random_speed() {
-  std::random_device rd;
-  std::mt19937 gen(rd());
+sf::Vector2f random_speed(std::mt19937 &gen) {
   std::uniform_real_distribution<float> distribution(-0.45f, 0.45f);
 
   float x = distribution(gen);
@@ -59,6 +43,10 @@ sf::Vector2f random_speed() {
   return sf::Vector2f(x, y);
 }
 
+float random_depth(std::mt19937 &gen) {
+  return std::generate_canonical<float, 10>(gen) * DEPTH;
+}
+
 sf::Color operator*(const sf::Color &color, float scalar) {
   return sf::Color(static_cast<std::uint8_t>(color.r * scalar),
                    static_cast<std::uint8_t>(color.g * scalar),